@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "aig_sweeping.hpp"
+
+#include "libs/ezsat/ezminisat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+/**
+ * @brief Integer representation of a literal, used for structural hashing
+ */
+std::uint64_t litData(Lit l) { return ((std::uint64_t)l.variable() << 1) | (l.polarity() ? 1 : 0); }
+
+/**
+ * @brief Apply the trivial simplifications of an And gate; return true if the gate is redundant
+ */
+bool simplifyAnd(Lit a, Lit b, Lit &res)
+{
+	if (a.is_constant() || b.is_constant()) {
+		// And with zero is zero, and with one is the other input
+		if (a.is_constant() && !a.polarity()) {
+			res = a;
+		} else if (b.is_constant() && !b.polarity()) {
+			res = b;
+		} else {
+			res = a.is_constant() ? b : a;
+		}
+		return true;
+	}
+	if (a.variable() == b.variable()) {
+		res = a.polarity() == b.polarity() ? a : Lit::zero();
+		return true;
+	}
+	return false;
+}
+} // namespace
+
+AigSweeper::AigSweeper(const MiniAIG &aig, const std::vector<char> &frozen)
+    : aig_(aig), frozen_(frozen), result_(aig.nbInputs()), nbMerged_(0), nbConstants_(0), nbStructural_(0), nbFailedChecks_(0),
+      nbAbortedChecks_(0)
+{
+	frozen_.resize(aig.nbInputs() + aig.nbNodes() + 1, 0);
+}
+
+std::vector<std::vector<std::uint64_t>> AigSweeper::simulate(int nbWords, std::uint64_t seed) const
+{
+	int nbInputs = aig_.nbInputs();
+	std::vector<std::vector<std::uint64_t>> sig(nbInputs + aig_.nbNodes() + 1, std::vector<std::uint64_t>(nbWords, 0));
+	std::mt19937_64 rgen(seed);
+	for (int v = 1; v <= nbInputs; ++v) {
+		for (int w = 0; w < nbWords; ++w) {
+			sig[v][w] = rgen();
+		}
+	}
+	for (int i = 0; i < aig_.nbNodes(); ++i) {
+		int v = i + nbInputs + 1;
+		if (frozen_[v]) {
+			for (int w = 0; w < nbWords; ++w) {
+				sig[v][w] = rgen();
+			}
+			continue;
+		}
+		Lit a = aig_.nodeA(i);
+		Lit b = aig_.nodeB(i);
+		std::uint64_t invA = a.polarity() ? (std::uint64_t)-1 : 0;
+		std::uint64_t invB = b.polarity() ? (std::uint64_t)-1 : 0;
+		const std::vector<std::uint64_t> &sigA = sig[a.variable()];
+		const std::vector<std::uint64_t> &sigB = sig[b.variable()];
+		for (int w = 0; w < nbWords; ++w) {
+			sig[v][w] = (sigA[w] ^ invA) & (sigB[w] ^ invB);
+		}
+	}
+	return sig;
+}
+
+void AigSweeper::run(int nbSimulationWords, std::uint64_t seed, int checkTimeout, int maxAbortedChecks, double timeLimit)
+{
+	if (nbSimulationWords <= 0) {
+		throw std::runtime_error("The number of simulation words for sweeping must be positive");
+	}
+	auto startTime = std::chrono::steady_clock::now();
+	int nbInputs = aig_.nbInputs();
+	int nbVars = nbInputs + aig_.nbNodes() + 1;
+	std::vector<std::vector<std::uint64_t>> sig = simulate(nbSimulationWords, seed);
+
+	// Patterns obtained from the counterexamples of the solver, to refine the classes (one bit each)
+	std::vector<std::vector<std::uint64_t>> cex(nbVars);
+	int nbCex = 0;
+	auto cexMask = [&](int w) -> std::uint64_t {
+		int nbBits = std::min(64, nbCex - 64 * w);
+		return nbBits == 64 ? (std::uint64_t)-1 : (((std::uint64_t)1 << nbBits) - 1);
+	};
+
+	// Signatures are normalized so that the first pattern is zero: complementary nodes share a class
+	auto phase = [&](int v) -> bool { return sig[v][0] & 1; };
+	auto signatureHash = [&](int v) -> std::uint64_t {
+		std::uint64_t inv = phase(v) ? (std::uint64_t)-1 : 0;
+		std::uint64_t h = 0;
+		for (std::uint64_t w : sig[v]) {
+			h = (h ^ (w ^ inv)) * 0x9E3779B97F4A7C15ULL;
+			h ^= h >> 29;
+		}
+		return h;
+	};
+	auto sameClass = [&](int u, int v) -> bool {
+		std::uint64_t inv = phase(u) != phase(v) ? (std::uint64_t)-1 : 0;
+		for (int w = 0; w < nbSimulationWords; ++w) {
+			if ((sig[u][w] ^ sig[v][w]) != inv) {
+				return false;
+			}
+		}
+		for (int w = 0; w < (int)cex[v].size(); ++w) {
+			if ((cex[u][w] ^ cex[v][w] ^ inv) & cexMask(w)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	result_ = MiniAIG(nbInputs);
+	mapping_.assign(nbVars, Lit::zero());
+	nbMerged_ = 0;
+	nbConstants_ = 0;
+	nbStructural_ = 0;
+	nbFailedChecks_ = 0;
+	nbAbortedChecks_ = 0;
+
+	// Sat literal of each variable of the reduced AIG; inputs and frozen nodes are free
+	ezMiniSAT sat;
+	sat.solverTimeout = checkTimeout;
+	std::vector<int> satVars;
+	satVars.push_back(ezSAT::CONST_FALSE);
+	auto toSat = [&](Lit l) -> int {
+		int s = satVars[l.variable()];
+		return l.polarity() ? sat.NOT(s) : s;
+	};
+	// Free Sat literals, and their index for each variable of the original AIG (-1 if not free)
+	std::vector<int> freeLits;
+	std::vector<int> freeIndex(nbVars, -1);
+	auto addFreeLiteral = [&](int v) {
+		int s = sat.literal();
+		sat.freeze(s);
+		satVars.push_back(s);
+		freeIndex[v] = freeLits.size();
+		freeLits.push_back(s);
+	};
+
+	// Simulate the counterexample patterns on a node of the original AIG
+	auto simulateCex = [&](int v) {
+		int i = v - nbInputs - 1;
+		Lit a = aig_.nodeA(i);
+		Lit b = aig_.nodeB(i);
+		std::uint64_t invA = a.polarity() ? (std::uint64_t)-1 : 0;
+		std::uint64_t invB = b.polarity() ? (std::uint64_t)-1 : 0;
+		cex[v].resize(cex[0].size());
+		for (std::size_t w = 0; w < cex[v].size(); ++w) {
+			cex[v][w] = frozen_[v] ? 0 : (cex[a.variable()][w] ^ invA) & (cex[b.variable()][w] ^ invB);
+		}
+	};
+	// Add the counterexample given by the values of the free literals, for the variables processed so far
+	auto addCex = [&](int lastVar, const std::vector<bool> &model) {
+		int w = nbCex / 64;
+		std::uint64_t bit = (std::uint64_t)1 << (nbCex % 64);
+		++nbCex;
+		for (int v = 0; v <= lastVar; ++v) {
+			cex[v].resize(w + 1, 0);
+			bool val;
+			if (freeIndex[v] >= 0) {
+				val = model[freeIndex[v]];
+			} else if (v <= nbInputs) {
+				val = false;
+			} else {
+				Lit a = aig_.nodeA(v - nbInputs - 1);
+				Lit b = aig_.nodeB(v - nbInputs - 1);
+				bool valA = ((cex[a.variable()][w] & bit) != 0) != a.polarity();
+				bool valB = ((cex[b.variable()][w] & bit) != 0) != b.polarity();
+				val = valA && valB;
+			}
+			if (val) {
+				cex[v][w] |= bit;
+			}
+		}
+	};
+	auto budgetExhausted = [&]() -> bool {
+		return nbAbortedChecks_ >= maxAbortedChecks ||
+		       std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() > timeLimit;
+	};
+
+	// Representatives of each equivalence class, and structural hashing of the reduced AIG
+	std::unordered_map<std::uint64_t, std::vector<int>> classes;
+	std::unordered_map<std::uint64_t, Lit> strash;
+	classes[signatureHash(0)].push_back(0);
+	for (int i = 0; i < nbInputs; ++i) {
+		int v = i + 1;
+		mapping_[v] = result_.getInput(i);
+		addFreeLiteral(v);
+		classes[signatureHash(v)].push_back(v);
+	}
+
+	for (int i = 0; i < aig_.nbNodes(); ++i) {
+		int v = i + nbInputs + 1;
+		Lit a = mapLit(aig_.nodeA(i));
+		Lit b = mapLit(aig_.nodeB(i));
+		simulateCex(v);
+		std::vector<int> &cls = classes[signatureHash(v)];
+		if (frozen_[v]) {
+			// Kept as is, but may still be used as a representative for the nodes it feeds
+			mapping_[v] = result_.addAnd(a, b);
+			addFreeLiteral(v);
+			cls.push_back(v);
+			continue;
+		}
+		Lit simplified;
+		if (simplifyAnd(a, b, simplified)) {
+			mapping_[v] = simplified;
+			++nbStructural_;
+			continue;
+		}
+		std::uint64_t dA = litData(a);
+		std::uint64_t dB = litData(b);
+		std::uint64_t key = dA < dB ? (dA << 32) | dB : (dB << 32) | dA;
+		auto it = strash.find(key);
+		if (it != strash.end()) {
+			mapping_[v] = it->second;
+			++nbStructural_;
+			continue;
+		}
+
+		// Check the candidate equivalences proposed by simulation with the solver
+		int candidate = sat.AND(toSat(a), toSat(b));
+		bool merged = false;
+		for (int u : cls) {
+			if (!sameClass(u, v)) {
+				continue;
+			}
+			if (budgetExhausted()) {
+				// Keep the node without checking
+				++nbAbortedChecks_;
+				break;
+			}
+			Lit repr = phase(u) != phase(v) ? mapping_[u].inv() : mapping_[u];
+			std::vector<bool> model;
+			bool satResult = sat.solve(freeLits, model, {sat.XOR(candidate, toSat(repr))});
+			if (sat.solverTimoutStatus) {
+				++nbAbortedChecks_;
+				break;
+			}
+			if (!satResult) {
+				mapping_[v] = repr;
+				merged = true;
+				if (repr.is_constant()) {
+					++nbConstants_;
+				} else {
+					++nbMerged_;
+				}
+				break;
+			}
+			// The counterexample separates the node from this representative, and from the
+			// other members of the class that agree with it on the new pattern
+			++nbFailedChecks_;
+			addCex(v, model);
+		}
+		if (merged) {
+			continue;
+		}
+		Lit n = result_.addAnd(a, b);
+		mapping_[v] = n;
+		sat.freeze(candidate);
+		satVars.push_back(candidate);
+		strash.emplace(key, n);
+		cls.push_back(v);
+	}
+
+	for (int i = 0; i < aig_.nbOutputs(); ++i) {
+		result_.addOutput(mapLit(aig_.output(i)));
+	}
+	result_.setupIncremental();
+	result_.check();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_AIG_SWEEPING_H
+#define MOOSIC_AIG_SWEEPING_H
+
+#include "mini_aig.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Merge equivalent and constant nodes of an AIG (SAT sweeping, or fraiging)
+ *
+ * Candidate equivalences are proposed by bit-parallel random simulation, then proven by
+ * incremental Sat queries before the nodes are merged. The counterexample of a failed check is
+ * added to the simulation patterns, which splits the candidate class before the next check. Trivial redundancies (duplicate gates,
+ * buffers, constants) are removed by structural hashing while the AIG is rebuilt.
+ *
+ * Frozen variables are the toggle points used for logic locking analysis. They are kept as
+ * distinct nodes and are treated as free variables (cut points) during the whole process, so
+ * that the merges remain valid whatever the nodes that are toggled.
+ */
+class AigSweeper
+{
+      public:
+	/**
+	 * @brief Initialize with the AIG to reduce and the variables to keep
+	 */
+	AigSweeper(const MiniAIG &aig, const std::vector<char> &frozen);
+
+	/**
+	 * @brief Run the sweeping
+	 *
+	 * Each Sat check has a time budget; a check that exceeds it is treated as not equivalent.
+	 * After too many aborted checks or when the total time limit is reached, the remaining
+	 * candidates are not checked at all, so that hard equivalences (multiplier-like logic) do
+	 * not stall the analysis.
+	 *
+	 * @param nbSimulationWords Number of 64-bit random patterns used to propose candidates
+	 * @param seed Seed for the random patterns
+	 * @param checkTimeout Time limit of each Sat check, in seconds
+	 * @param maxAbortedChecks Number of aborted checks after which the remaining candidates are skipped
+	 * @param timeLimit Time limit of all Sat checks, in seconds
+	 */
+	void run(int nbSimulationWords = 16, std::uint64_t seed = 1, int checkTimeout = 1, int maxAbortedChecks = 8, double timeLimit = 10.0);
+
+	/**
+	 * @brief Access the reduced AIG
+	 */
+	const MiniAIG &result() const { return result_; }
+
+	/**
+	 * @brief Obtain the literal of the reduced AIG corresponding to a literal of the original AIG
+	 */
+	Lit mapLit(Lit l) const { return l.polarity() ? mapping_[l.variable()].inv() : mapping_[l.variable()]; }
+
+	/**
+	 * @brief Number of nodes proven equivalent to another node
+	 */
+	int nbMerged() const { return nbMerged_; }
+
+	/**
+	 * @brief Number of nodes proven constant
+	 */
+	int nbConstants() const { return nbConstants_; }
+
+	/**
+	 * @brief Number of nodes removed by structural hashing
+	 */
+	int nbStructural() const { return nbStructural_; }
+
+	/**
+	 * @brief Number of candidate equivalences disproven by the solver
+	 */
+	int nbFailedChecks() const { return nbFailedChecks_; }
+
+	/**
+	 * @brief Number of candidate equivalences left unproven, because of the time budgets
+	 */
+	int nbAbortedChecks() const { return nbAbortedChecks_; }
+
+      private:
+	/**
+	 * @brief Compute the simulation signature of each variable, with frozen variables as random inputs
+	 */
+	std::vector<std::vector<std::uint64_t>> simulate(int nbWords, std::uint64_t seed) const;
+
+      private:
+	const MiniAIG &aig_;
+	std::vector<char> frozen_;
+	MiniAIG result_;
+	std::vector<Lit> mapping_;
+	int nbMerged_;
+	int nbConstants_;
+	int nbStructural_;
+	int nbFailedChecks_;
+	int nbAbortedChecks_;
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "aiger.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+const std::string togglePrefix = "moosic-toggle";
+
+void writeDelta(std::ostream &f, std::uint32_t x)
+{
+	while (x & ~0x7fU) {
+		f.put((char)((x & 0x7f) | 0x80));
+		x >>= 7;
+	}
+	f.put((char)x);
+}
+
+std::uint32_t readDelta(std::istream &f)
+{
+	std::uint32_t x = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		int c = f.get();
+		if (c == std::char_traits<char>::eof()) {
+			throw std::runtime_error("Unexpected end of Aiger file in the and gates");
+		}
+		x |= (std::uint32_t)(c & 0x7f) << shift;
+		if (!(c & 0x80)) {
+			return x;
+		}
+	}
+	throw std::runtime_error("Invalid delta encoding in Aiger file");
+}
+
+std::uint32_t readLiteralLine(std::istream &f, std::uint32_t maxVar)
+{
+	std::string line;
+	if (!std::getline(f, line)) {
+		throw std::runtime_error("Unexpected end of Aiger file");
+	}
+	std::istringstream s(line);
+	std::uint32_t lit;
+	if (!(s >> lit) || lit / 2 > maxVar) {
+		throw std::runtime_error("Invalid literal in Aiger file: " + line);
+	}
+	return lit;
+}
+} // namespace
+
+void writeAiger(std::ostream &f, const MiniAIG &aig, const AigerSymbols &symbols)
+{
+	std::uint32_t nbInputs = aig.nbInputs();
+	std::uint32_t nbNodes = aig.nbNodes();
+	f << "aig " << nbInputs + nbNodes << " " << nbInputs << " 0 " << aig.nbOutputs() << " " << nbNodes << "\n";
+	for (int o = 0; o < aig.nbOutputs(); ++o) {
+		f << aig.output(o).raw() << "\n";
+	}
+	for (std::uint32_t i = 0; i < nbNodes; ++i) {
+		std::uint32_t lhs = 2 * (nbInputs + i + 1);
+		std::uint32_t a = aig.nodeA(i).raw();
+		std::uint32_t b = aig.nodeB(i).raw();
+		std::uint32_t rhs0 = std::max(a, b);
+		std::uint32_t rhs1 = std::min(a, b);
+		if (rhs0 >= lhs) {
+			throw std::runtime_error("Aig nodes are not in topological order");
+		}
+		writeDelta(f, lhs - rhs0);
+		writeDelta(f, rhs0 - rhs1);
+	}
+	for (std::size_t i = 0; i < symbols.inputs.size(); ++i) {
+		if (!symbols.inputs[i].empty()) {
+			f << "i" << i << " " << symbols.inputs[i] << "\n";
+		}
+	}
+	for (std::size_t i = 0; i < symbols.outputs.size(); ++i) {
+		if (!symbols.outputs[i].empty()) {
+			f << "o" << i << " " << symbols.outputs[i] << "\n";
+		}
+	}
+	f << "c\n";
+	for (const auto &t : symbols.togglePoints) {
+		f << togglePrefix << " " << t.second.raw() << " " << t.first << "\n";
+	}
+}
+
+MiniAIG readAiger(std::istream &f, AigerSymbols &symbols)
+{
+	std::string line;
+	if (!std::getline(f, line)) {
+		throw std::runtime_error("Empty Aiger file");
+	}
+	std::istringstream header(line);
+	std::string format;
+	std::uint32_t maxVar, nbInputs, nbLatches, nbOutputs, nbAnds;
+	if (!(header >> format >> maxVar >> nbInputs >> nbLatches >> nbOutputs >> nbAnds)) {
+		throw std::runtime_error("Invalid Aiger header: " + line);
+	}
+	if (format != "aig") {
+		throw std::runtime_error("Only the binary Aiger format is supported");
+	}
+	std::uint32_t extra;
+	while (header >> extra) {
+		if (extra != 0) {
+			throw std::runtime_error("Aiger bad states, constraints, justice and fairness properties are not supported");
+		}
+	}
+	if ((std::uint64_t)nbInputs + nbLatches + nbAnds != maxVar) {
+		throw std::runtime_error("Invalid Aiger header: the number of variables does not match");
+	}
+
+	// Latch outputs are the variables right after the inputs, and become inputs of the Aig
+	std::vector<std::uint32_t> latchNext;
+	for (std::uint32_t i = 0; i < nbLatches; ++i) {
+		latchNext.push_back(readLiteralLine(f, maxVar));
+	}
+	std::vector<std::uint32_t> outputs;
+	for (std::uint32_t i = 0; i < nbOutputs; ++i) {
+		outputs.push_back(readLiteralLine(f, maxVar));
+	}
+
+	MiniAIG aig(nbInputs + nbLatches);
+	for (std::uint32_t i = 0; i < nbAnds; ++i) {
+		std::uint32_t lhs = 2 * (nbInputs + nbLatches + i + 1);
+		std::uint32_t delta0 = readDelta(f);
+		std::uint32_t delta1 = readDelta(f);
+		if (delta0 == 0 || delta0 > lhs || delta1 > lhs - delta0) {
+			throw std::runtime_error("Invalid and gate in Aiger file");
+		}
+		std::uint32_t rhs0 = lhs - delta0;
+		std::uint32_t rhs1 = rhs0 - delta1;
+		aig.addAnd(Lit::fromRaw(rhs0), Lit::fromRaw(rhs1));
+	}
+	for (std::uint32_t o : outputs) {
+		aig.addOutput(Lit::fromRaw(o));
+	}
+	for (std::uint32_t o : latchNext) {
+		aig.addOutput(Lit::fromRaw(o));
+	}
+
+	// Symbol table, then comments
+	symbols.inputs.assign(nbInputs + nbLatches, std::string());
+	symbols.outputs.assign(nbOutputs + nbLatches, std::string());
+	symbols.togglePoints.clear();
+	bool inComments = false;
+	while (std::getline(f, line)) {
+		if (!inComments) {
+			if (line == "c") {
+				inComments = true;
+				continue;
+			}
+			std::size_t space = line.find(' ');
+			if (line.size() < 2 || space == std::string::npos || space < 2) {
+				throw std::runtime_error("Invalid symbol in Aiger file: " + line);
+			}
+			std::istringstream posStream(line.substr(1, space - 1));
+			std::uint32_t pos;
+			if (!(posStream >> pos) || !posStream.eof()) {
+				throw std::runtime_error("Invalid symbol in Aiger file: " + line);
+			}
+			std::string name = line.substr(space + 1);
+			char kind = line[0];
+			if (kind == 'i') {
+				if (pos >= nbInputs) {
+					throw std::runtime_error("Invalid input symbol in Aiger file: " + line);
+				}
+				symbols.inputs[pos] = name;
+			} else if (kind == 'l') {
+				if (pos >= nbLatches) {
+					throw std::runtime_error("Invalid latch symbol in Aiger file: " + line);
+				}
+				symbols.inputs[nbInputs + pos] = name;
+				symbols.outputs[nbOutputs + pos] = name + "$next";
+			} else if (kind == 'o') {
+				if (pos >= nbOutputs) {
+					throw std::runtime_error("Invalid output symbol in Aiger file: " + line);
+				}
+				symbols.outputs[pos] = name;
+			} else if (kind != 'b' && kind != 'c' && kind != 'j' && kind != 'f') {
+				// Bad states, constraints, justice and fairness properties are valid but ignored
+				throw std::runtime_error("Unknown symbol kind in Aiger file: " + line);
+			}
+			continue;
+		}
+		std::istringstream s(line);
+		std::string prefix;
+		std::uint32_t lit;
+		if (s >> prefix >> lit && prefix == togglePrefix) {
+			if (lit / 2 > maxVar) {
+				throw std::runtime_error("Invalid toggle point in Aiger file: " + line);
+			}
+			std::string name;
+			std::getline(s >> std::ws, name);
+			symbols.togglePoints.emplace_back(name, Lit::fromRaw(lit));
+		}
+	}
+	aig.setupIncremental();
+	return aig;
+}
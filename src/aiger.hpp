@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_AIGER_H
+#define MOOSIC_AIGER_H
+
+#include "mini_aig.hpp"
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Names and toggle points attached to an Aig in an Aiger file
+ *
+ * Inputs and outputs are named in the symbol table. Toggle points (the lockable signals of the
+ * design, with their literal) are not part of the Aiger format, and are stored in the comment
+ * section as "moosic-toggle <literal> <name>" lines, that other tools ignore.
+ */
+struct AigerSymbols {
+	/// Name of each input, or empty
+	std::vector<std::string> inputs;
+	/// Name of each output, or empty
+	std::vector<std::string> outputs;
+	/// Name and literal of each toggle point
+	std::vector<std::pair<std::string, Lit>> togglePoints;
+};
+
+/**
+ * @brief Write the Aig in binary Aiger format, with its symbols
+ */
+void writeAiger(std::ostream &f, const MiniAIG &aig, const AigerSymbols &symbols);
+
+/**
+ * @brief Read an Aig in binary Aiger format, with its symbols
+ *
+ * Latches are cut as in the analysis of a design: the latch outputs become additional inputs
+ * after the primary inputs, and the latch next states become additional outputs after the primary outputs.
+ * Throws std::runtime_error on malformed files.
+ */
+MiniAIG readAiger(std::istream &f, AigerSymbols &symbols);
+
+#endif
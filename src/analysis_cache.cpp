@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "analysis_cache.hpp"
+
+#include "kernel/yosys.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+USING_YOSYS_NAMESPACE
+
+namespace
+{
+/// Version of the file format; bump when the format or the conversion to Aig changes
+constexpr std::uint32_t formatVersion = 2;
+
+constexpr char fileMagic[8] = {'M', 'O', 'O', 'S', 'I', 'C', 'A', 'C'};
+
+/// Literal stored for signals without an Aig representation
+constexpr std::uint32_t noLiteral = (std::uint32_t)-1;
+
+enum class ArtifactKind : std::uint32_t { Aig = 1, Corruption = 2, Pairwise = 3 };
+
+struct FileHeader {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t kind;
+	std::uint64_t hash;
+	std::uint64_t reserved;
+};
+
+std::string cache_directory;
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t v) { return (h ^ v) * 0x100000001b3ULL; }
+
+std::uint64_t mix(std::uint64_t h, const std::string &s)
+{
+	for (char c : s) {
+		h = mix(h, (unsigned char)c);
+	}
+	// Terminator, so that consecutive strings cannot be confused
+	return mix(h, 0xff);
+}
+
+std::uint64_t mix(std::uint64_t h, const SigSpec &sig)
+{
+	for (SigBit b : sig) {
+		h = b.wire ? mix(mix(h, b.wire->name.str()), b.offset) : mix(h, b.data);
+	}
+	return h;
+}
+
+std::uint64_t mix(std::uint64_t h, const Const &value) { return mix(mix(h, value.as_string()), value.flags); }
+
+/**
+ * @brief Mix named values (parameters or attributes) in name order, so that the result does not depend on their insertion order
+ */
+std::uint64_t mix(std::uint64_t h, const dict<IdString, Const> &values, bool skip_src)
+{
+	std::vector<std::pair<std::string, const Const *>> sorted;
+	for (const auto &it : values) {
+		if (skip_src && it.first == ID::src) {
+			continue;
+		}
+		sorted.emplace_back(it.first.str(), &it.second);
+	}
+	std::sort(sorted.begin(), sorted.end());
+	for (const auto &it : sorted) {
+		h = mix(mix(h, it.first), *it.second);
+	}
+	return mix(h, sorted.size());
+}
+
+/**
+ * @brief Write an artifact to a temporary file, then move it in place so that concurrent runs never see a partial file
+ */
+class ArtifactWriter
+{
+      public:
+	ArtifactWriter(const std::string &path, ArtifactKind kind, std::uint64_t hash)
+	    : path_(path), tmpPath_(path + ".tmp"), f_(tmpPath_, std::ios::binary | std::ios::trunc)
+	{
+		FileHeader header;
+		std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+		header.version = formatVersion;
+		header.kind = (std::uint32_t)kind;
+		header.hash = hash;
+		header.reserved = 0;
+		f_.write((const char *)&header, sizeof(header));
+	}
+
+	template <typename T> void write_array(const std::vector<T> &v)
+	{
+		std::uint64_t n = v.size();
+		f_.write((const char *)&n, sizeof(n));
+		f_.write((const char *)v.data(), n * sizeof(T));
+		std::uint64_t padding = 0;
+		f_.write((const char *)&padding, (8 - n * sizeof(T) % 8) % 8);
+	}
+
+	void commit()
+	{
+		f_.close();
+		if (!f_ || std::rename(tmpPath_.c_str(), path_.c_str()) != 0) {
+			log_warning("Could not write analysis cache file %s.\n", path_.c_str());
+			std::remove(tmpPath_.c_str());
+		}
+	}
+
+      private:
+	std::string path_;
+	std::string tmpPath_;
+	std::ofstream f_;
+};
+
+/**
+ * @brief Read an artifact, checking its header and the size of each array against the file size
+ */
+class ArtifactReader
+{
+      public:
+	ArtifactReader(const std::string &path, ArtifactKind kind, std::uint64_t hash) : f_(path, std::ios::binary | std::ios::ate), ok_(false)
+	{
+		if (!f_) {
+			return;
+		}
+		remaining_ = f_.tellg();
+		f_.seekg(0);
+		FileHeader header;
+		if (remaining_ < sizeof(header) || !f_.read((char *)&header, sizeof(header))) {
+			return;
+		}
+		remaining_ -= sizeof(header);
+		ok_ = std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) == 0 && header.version == formatVersion &&
+		      header.kind == (std::uint32_t)kind && header.hash == hash;
+	}
+
+	bool ok() const { return ok_; }
+
+	template <typename T> bool read_array(std::vector<T> &v)
+	{
+		std::uint64_t n = 0;
+		if (!ok_ || remaining_ < sizeof(n) || !f_.read((char *)&n, sizeof(n))) {
+			return ok_ = false;
+		}
+		remaining_ -= sizeof(n);
+		std::uint64_t bytes = n * sizeof(T) + (8 - n * sizeof(T) % 8) % 8;
+		if (n > remaining_ / sizeof(T) || bytes > remaining_) {
+			return ok_ = false;
+		}
+		v.resize(n);
+		if (!f_.read((char *)v.data(), n * sizeof(T))) {
+			return ok_ = false;
+		}
+		f_.seekg(bytes - n * sizeof(T), std::ios::cur);
+		remaining_ -= bytes;
+		return true;
+	}
+
+      private:
+	std::ifstream f_;
+	std::uint64_t remaining_;
+	bool ok_;
+};
+} // namespace
+
+void AnalysisCache::set_directory(const std::string &dir)
+{
+	cache_directory = dir;
+	if (!dir.empty()) {
+		boost::system::error_code ec;
+		boost::filesystem::create_directories(dir, ec);
+		if (ec) {
+			log_cmd_error("Could not create the cache directory %s: %s\n", dir.c_str(), ec.message().c_str());
+		}
+	}
+}
+
+bool AnalysisCache::enabled() { return !cache_directory.empty(); }
+
+std::uint64_t AnalysisCache::canonical_hash(Module *module)
+{
+	std::uint64_t h = mix(0xcbf29ce484222325ULL, formatVersion);
+	h = mix(h, module->name.str());
+	for (Wire *w : module->wires()) {
+		h = mix(mix(h, w->name.str()), w->width);
+		h = mix(mix(h, w->port_id), (w->port_input ? 1 : 0) | (w->port_output ? 2 : 0));
+	}
+	for (Cell *c : module->cells()) {
+		h = mix(mix(h, c->name.str()), c->type.str());
+		// Parameters give the function of the cell (LUT tables, widths, signedness); source locations are irrelevant
+		h = mix(h, c->parameters, false);
+		h = mix(h, c->attributes, true);
+		for (auto conn : c->connections()) {
+			h = mix(mix(h, conn.first.str()), conn.second);
+		}
+	}
+	for (auto conn : module->connections()) {
+		h = mix(mix(h, conn.first), conn.second);
+	}
+	return h;
+}
+
+std::string AnalysisCache::artifact_path(std::uint64_t hash, const std::string &name)
+{
+	return stringf("%s/%016llx-%s.bin", cache_directory.c_str(), (unsigned long long)hash, name.c_str());
+}
+
+bool AnalysisCache::load_aig(const std::string &path, std::uint64_t hash, MiniAIG &aig, std::vector<Lit> &signal_lits, std::vector<char> &has_lit)
+{
+	ArtifactReader reader(path, ArtifactKind::Aig, hash);
+	std::vector<std::uint32_t> sizes, nodes, outputs, lits;
+	if (!reader.read_array(sizes) || sizes.size() != 1 || !reader.read_array(nodes) || !reader.read_array(outputs) ||
+	    !reader.read_array(lits) || nodes.size() % 2 != 0) {
+		return false;
+	}
+	// Nodes must be in topological order: each node only uses the inputs and the previous nodes
+	std::uint32_t nbVars = sizes[0] + 1;
+	aig = MiniAIG(sizes[0]);
+	for (std::size_t i = 0; i < nodes.size(); i += 2) {
+		if (Lit::fromRaw(nodes[i]).variable() >= nbVars || Lit::fromRaw(nodes[i + 1]).variable() >= nbVars) {
+			return false;
+		}
+		aig.addAnd(Lit::fromRaw(nodes[i]), Lit::fromRaw(nodes[i + 1]));
+		++nbVars;
+	}
+	for (std::uint32_t o : outputs) {
+		if (Lit::fromRaw(o).variable() >= nbVars) {
+			return false;
+		}
+		aig.addOutput(Lit::fromRaw(o));
+	}
+	signal_lits.assign(lits.size(), Lit::zero());
+	has_lit.assign(lits.size(), false);
+	for (std::size_t i = 0; i < lits.size(); ++i) {
+		if (lits[i] == noLiteral) {
+			continue;
+		}
+		if (Lit::fromRaw(lits[i]).variable() >= nbVars) {
+			return false;
+		}
+		signal_lits[i] = Lit::fromRaw(lits[i]);
+		has_lit[i] = true;
+	}
+	aig.setupIncremental();
+	return true;
+}
+
+void AnalysisCache::save_aig(const std::string &path, std::uint64_t hash, const MiniAIG &aig, const std::vector<Lit> &signal_lits,
+			     const std::vector<char> &has_lit)
+{
+	std::vector<std::uint32_t> sizes = {(std::uint32_t)aig.nbInputs()};
+	std::vector<std::uint32_t> nodes, outputs, lits;
+	for (int i = 0; i < aig.nbNodes(); ++i) {
+		nodes.push_back(aig.nodeA(i).raw());
+		nodes.push_back(aig.nodeB(i).raw());
+	}
+	for (int o = 0; o < aig.nbOutputs(); ++o) {
+		outputs.push_back(aig.output(o).raw());
+	}
+	for (std::size_t i = 0; i < signal_lits.size(); ++i) {
+		lits.push_back(has_lit[i] ? signal_lits[i].raw() : noLiteral);
+	}
+	ArtifactWriter writer(path, ArtifactKind::Aig, hash);
+	writer.write_array(sizes);
+	writer.write_array(nodes);
+	writer.write_array(outputs);
+	writer.write_array(lits);
+	writer.commit();
+}
+
+bool AnalysisCache::load_corruption(const std::string &path, std::uint64_t hash, std::vector<std::vector<std::vector<std::uint64_t>>> &data)
+{
+	ArtifactReader reader(path, ArtifactKind::Corruption, hash);
+	std::vector<std::uint32_t> sizes;
+	std::vector<std::uint64_t> flat;
+	if (!reader.read_array(sizes) || sizes.size() != 3 || !reader.read_array(flat) ||
+	    flat.size() != (std::uint64_t)sizes[0] * sizes[1] * sizes[2]) {
+		return false;
+	}
+	data.assign(sizes[0], std::vector<std::vector<std::uint64_t>>(sizes[1]));
+	auto it = flat.begin();
+	for (auto &signal : data) {
+		for (auto &output : signal) {
+			output.assign(it, it + sizes[2]);
+			it += sizes[2];
+		}
+	}
+	return true;
+}
+
+void AnalysisCache::save_corruption(const std::string &path, std::uint64_t hash, const std::vector<std::vector<std::vector<std::uint64_t>>> &data)
+{
+	std::uint32_t nbOutputs = data.empty() ? 0 : data[0].size();
+	std::uint32_t nbTestVectors = nbOutputs == 0 ? 0 : data[0][0].size();
+	std::vector<std::uint32_t> sizes = {(std::uint32_t)data.size(), nbOutputs, nbTestVectors};
+	std::vector<std::uint64_t> flat;
+	flat.reserve((std::uint64_t)data.size() * nbOutputs * nbTestVectors);
+	for (const auto &signal : data) {
+		for (const auto &output : signal) {
+			flat.insert(flat.end(), output.begin(), output.end());
+		}
+	}
+	ArtifactWriter writer(path, ArtifactKind::Corruption, hash);
+	writer.write_array(sizes);
+	writer.write_array(flat);
+	writer.commit();
+}
+
+bool AnalysisCache::load_pairwise(const std::string &path, std::uint64_t hash, std::vector<std::pair<int, int>> &edges)
+{
+	ArtifactReader reader(path, ArtifactKind::Pairwise, hash);
+	std::vector<std::uint32_t> flat;
+	if (!reader.read_array(flat) || flat.size() % 2 != 0) {
+		return false;
+	}
+	edges.clear();
+	for (std::size_t i = 0; i < flat.size(); i += 2) {
+		edges.emplace_back(flat[i], flat[i + 1]);
+	}
+	return true;
+}
+
+void AnalysisCache::save_pairwise(const std::string &path, std::uint64_t hash, const std::vector<std::pair<int, int>> &edges)
+{
+	std::vector<std::uint32_t> flat;
+	for (auto e : edges) {
+		flat.push_back(e.first);
+		flat.push_back(e.second);
+	}
+	ArtifactWriter writer(path, ArtifactKind::Pairwise, hash);
+	writer.write_array(flat);
+	writer.commit();
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_ANALYSIS_CACHE_H
+#define MOOSIC_ANALYSIS_CACHE_H
+
+#include "kernel/rtlil.h"
+
+#include "mini_aig.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Persistent storage of analysis results, reused between runs on the same netlist
+ *
+ * Each artifact is a file in the cache directory, named after the canonical hash of the module and
+ * the parameters of the analysis. A file is a fixed header (magic, format version, kind of artifact,
+ * module hash) followed by flat arrays of fixed-width integers, each prefixed by its size and aligned
+ * on 8 bytes, and is read sequentially in a single pass. Files that do not match the
+ * expected version, kind or hash are ignored and recomputed.
+ */
+class AnalysisCache
+{
+      public:
+	/**
+	 * @brief Set the cache directory, created if needed; an empty string disables the cache
+	 */
+	static void set_directory(const std::string &dir);
+
+	/**
+	 * @brief Whether a cache directory is set
+	 */
+	static bool enabled();
+
+	/**
+	 * @brief Hash of the module based on names, types and connections, stable between runs
+	 */
+	static std::uint64_t canonical_hash(Yosys::RTLIL::Module *module);
+
+	/**
+	 * @brief Path of an artifact for a module in the cache directory
+	 */
+	static std::string artifact_path(std::uint64_t hash, const std::string &name);
+
+	/**
+	 * @brief Load the Aig of a module and the literal of each signal (absent signals have no literal)
+	 */
+	static bool load_aig(const std::string &path, std::uint64_t hash, MiniAIG &aig, std::vector<Lit> &signal_lits,
+			     std::vector<char> &has_lit);
+
+	/**
+	 * @brief Save the Aig of a module and the literal of each signal
+	 */
+	static void save_aig(const std::string &path, std::uint64_t hash, const MiniAIG &aig, const std::vector<Lit> &signal_lits,
+			     const std::vector<char> &has_lit);
+
+	/**
+	 * @brief Load corruption data (per signal per output per test vector)
+	 */
+	static bool load_corruption(const std::string &path, std::uint64_t hash, std::vector<std::vector<std::vector<std::uint64_t>>> &data);
+
+	/**
+	 * @brief Save corruption data (per signal per output per test vector)
+	 */
+	static void save_corruption(const std::string &path, std::uint64_t hash, const std::vector<std::vector<std::vector<std::uint64_t>>> &data);
+
+	/**
+	 * @brief Load the edges of the pairwise security graph
+	 */
+	static bool load_pairwise(const std::string &path, std::uint64_t hash, std::vector<std::pair<int, int>> &edges);
+
+	/**
+	 * @brief Save the edges of the pairwise security graph
+	 */
+	static void save_pairwise(const std::string &path, std::uint64_t hash, const std::vector<std::pair<int, int>> &edges);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "analysis_context.hpp"
+#include "analysis_cache.hpp"
+#include "phase_trace.hpp"
+
+#include "kernel/yosys.h"
+
+#include <map>
+#include <memory>
+
+USING_YOSYS_NAMESPACE
+
+namespace
+{
+/// Maximum number of test vector configurations kept for each module
+constexpr int maxConfigurations = 4;
+
+struct ModuleAnalysis {
+	/// Structural hash of the module when it was analyzed
+	std::uint64_t hash = 0;
+	/// Canonical hash of the module for the persistent cache, if computed
+	std::uint64_t canonical_hash = 0;
+	bool has_canonical_hash = false;
+	/// Analyzer without test vectors
+	std::unique_ptr<LogicLockingAnalyzer> base;
+	/// Analyzers with their test vectors, by number of test vectors and seed
+	std::map<std::pair<int, size_t>, LogicLockingAnalyzer> configurations;
+};
+
+/// Cached analyses, by module identifier
+std::map<unsigned int, ModuleAnalysis> cache;
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t v) { return (h ^ v) * 0x100000001b3ULL; }
+
+std::uint64_t mix(std::uint64_t h, const SigSpec &sig)
+{
+	for (SigBit b : sig) {
+		h = b.wire ? mix(mix(h, b.wire->hashidx_), b.offset) : mix(h, b.data);
+	}
+	return h;
+}
+
+std::uint64_t mix(std::uint64_t h, const Const &value)
+{
+	for (char c : value.as_string()) {
+		h = mix(h, (unsigned char)c);
+	}
+	return mix(h, value.flags);
+}
+
+/**
+ * @brief Remove the analyses of modules that are not in the design anymore
+ */
+void prune_cache(Design *design)
+{
+	pool<unsigned int> live;
+	for (Module *m : design->modules()) {
+		live.insert(m->hashidx_);
+	}
+	for (auto it = cache.begin(); it != cache.end();) {
+		if (live.count(it->first)) {
+			++it;
+		} else {
+			it = cache.erase(it);
+		}
+	}
+}
+} // namespace
+
+std::uint64_t AnalysisContext::structural_hash(Module *module)
+{
+	std::uint64_t h = 0xcbf29ce484222325ULL;
+	for (Wire *w : module->wires()) {
+		h = mix(mix(h, w->hashidx_), w->width);
+		h = mix(h, (w->port_input ? 1 : 0) | (w->port_output ? 2 : 0));
+	}
+	for (Cell *c : module->cells()) {
+		h = mix(mix(h, c->hashidx_), c->type.index_);
+		for (const auto &param : c->parameters) {
+			h = mix(mix(h, param.first.index_), param.second);
+		}
+		for (auto conn : c->connections()) {
+			h = mix(mix(h, conn.first.index_), conn.second);
+		}
+	}
+	for (auto conn : module->connections()) {
+		h = mix(mix(h, conn.first), conn.second);
+	}
+	return h;
+}
+
+LogicLockingAnalyzer AnalysisContext::get_analyzer(Module *module, int nb_test_vectors, size_t seed)
+{
+	TraceScope trace("get_analyzer");
+	trace.addCounter("cells", GetSize(module->cells_));
+	trace.addCounter("test_vectors", nb_test_vectors);
+	if (module->design != nullptr) {
+		prune_cache(module->design);
+	}
+	std::uint64_t hash = structural_hash(module);
+	ModuleAnalysis &analysis = cache[module->hashidx_];
+	if (analysis.base && analysis.hash == hash) {
+		log("Reusing the analysis of module %s from a previous pass.\n", log_id(module->name));
+	} else {
+		analysis.hash = hash;
+		analysis.has_canonical_hash = AnalysisCache::enabled();
+		analysis.configurations.clear();
+		if (analysis.has_canonical_hash) {
+			analysis.canonical_hash = AnalysisCache::canonical_hash(module);
+			analysis.base.reset(new LogicLockingAnalyzer(module, analysis.canonical_hash));
+		} else {
+			analysis.base.reset(new LogicLockingAnalyzer(module));
+		}
+	}
+	if (AnalysisCache::enabled() && !analysis.has_canonical_hash) {
+		analysis.canonical_hash = AnalysisCache::canonical_hash(module);
+		analysis.has_canonical_hash = true;
+	}
+
+	std::pair<int, size_t> key(nb_test_vectors, seed);
+	auto it = analysis.configurations.find(key);
+	if (it == analysis.configurations.end()) {
+		if (GetSize(analysis.configurations) >= maxConfigurations) {
+			analysis.configurations.erase(analysis.configurations.begin());
+		}
+		LogicLockingAnalyzer pw = *analysis.base;
+		pw.gen_test_vectors(nb_test_vectors, seed);
+		it = analysis.configurations.emplace(key, pw).first;
+	}
+	if (AnalysisCache::enabled()) {
+		// The test vectors are entirely determined by their number and seed
+		it->second.persist_test_vector_data(analysis.canonical_hash, stringf("v%d-s%zu", nb_test_vectors, seed));
+	}
+	return it->second;
+}
+
+void AnalysisContext::clear() { cache.clear(); }
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_ANALYSIS_CONTEXT_H
+#define MOOSIC_ANALYSIS_CONTEXT_H
+
+#include "kernel/rtlil.h"
+
+#include "logic_locking_analyzer.hpp"
+
+#include <cstdint>
+
+/**
+ * @brief Analysis of the modules of a design, shared between passes
+ *
+ * Building the Aig of a module is a large part of the runtime of most passes. The context keeps
+ * the analyzers of the modules, with their test vectors and corruption data, and reuses them as
+ * long as the module is structurally unchanged.
+ */
+class AnalysisContext
+{
+      public:
+	/**
+	 * @brief Obtain an analyzer for the module with the given test vectors, reusing a previous analysis if the
+	 * module did not change
+	 *
+	 * The analyzer returned is a copy, that may be modified without affecting the cached analysis.
+	 */
+	static LogicLockingAnalyzer get_analyzer(Module *module, int nb_test_vectors = 0, size_t seed = 1);
+
+	/**
+	 * @brief Remove all cached analyses
+	 */
+	static void clear();
+
+	/**
+	 * @brief Hash of the cells, wires and connections of the module, used to detect modifications
+	 */
+	static std::uint64_t structural_hash(Module *module);
+};
+
+#endif
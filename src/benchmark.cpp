@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "benchmark.hpp"
+
+#include <sys/resource.h>
+
+#include <chrono>
+
+namespace
+{
+long peakRssKb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+} // namespace
+
+BenchResult runBench(const std::string &name, int nbNodes, int nbCandidates, const std::string &unit, double minTime,
+		     const std::function<double()> &kernel)
+{
+	BenchResult res;
+	res.name = name;
+	res.nbNodes = nbNodes;
+	res.nbCandidates = nbCandidates;
+	res.unit = unit;
+	res.iterations = 0;
+	double work = 0.0;
+	auto start = std::chrono::steady_clock::now();
+	do {
+		work += kernel();
+		++res.iterations;
+		res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (res.seconds < minTime);
+	res.throughput = work / res.seconds;
+	res.peakRssKb = peakRssKb();
+	return res;
+}
+
+void writeBenchJson(std::ostream &f, const std::vector<BenchResult> &results)
+{
+	f << "{\n  \"benchmarks\": [\n";
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const BenchResult &r = results[i];
+		f << "    {\"name\": \"" << r.name << "\", \"nodes\": " << r.nbNodes << ", \"candidates\": " << r.nbCandidates
+		  << ", \"iterations\": " << r.iterations << ", \"seconds\": " << r.seconds << ", \"throughput\": " << r.throughput
+		  << ", \"unit\": \"" << r.unit << "\", \"peak_rss_kb\": " << r.peakRssKb << "}" << (i + 1 < results.size() ? "," : "")
+		  << "\n";
+	}
+	f << "  ]\n}\n";
+}
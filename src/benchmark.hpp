@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_BENCHMARK_H
+#define MOOSIC_BENCHMARK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Result of a microbenchmark, written as one JSON row by moosic_bench and ll_bench
+ */
+struct BenchResult {
+	/// Name of the kernel
+	std::string name;
+	/// Size of the design, in Aig nodes
+	int nbNodes;
+	/// Number of signals, graph nodes or key bits processed by the kernel, which may be capped below the size of the design
+	int nbCandidates;
+	long long iterations;
+	double seconds;
+	double throughput;
+	std::string unit;
+	/// Peak memory of the process after the kernel ran
+	long peakRssKb;
+};
+
+/**
+ * @brief Run a kernel repeatedly for at least the given time
+ *
+ * @param kernel Runs the kernel once and returns the amount of work done, in the unit of the benchmark
+ */
+BenchResult runBench(const std::string &name, int nbNodes, int nbCandidates, const std::string &unit, double minTime,
+		     const std::function<double()> &kernel);
+
+/**
+ * @brief Write the results as JSON
+ */
+void writeBenchJson(std::ostream &f, const std::vector<BenchResult> &results);
+
+#endif
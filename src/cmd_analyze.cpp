@@ -5,6 +5,7 @@
 #include "kernel/yosys.h"
 
 #include "command_utils.hpp"
+#include "phase_trace.hpp"
 
 #include <limits>
 
@@ -22,6 +23,13 @@ struct LogicLockingAnalyzePass : public Pass {
 		std::vector<int> solution;
 		std::vector<bool> key;
 		std::string port_name = "moosic_key";
+		bool skew = false;
+		bool profile = false;
+		int nbScreeningPatterns = 0;
+		std::uint64_t nbSkewPatterns = 1 << 20;
+		int nbThreads = 0;
+		int nbReported = 20;
+		std::string traceFile;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -57,12 +65,60 @@ struct LogicLockingAnalyzePass : public Pass {
 				key = parse_hex_string_to_bool(args[++argidx]);
 				continue;
 			}
+			if (arg == "-skew") {
+				skew = true;
+				continue;
+			}
+			if (arg == "-profile") {
+				profile = true;
+				continue;
+			}
+			if (arg == "-screen") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbScreeningPatterns = std::atoi(args[++argidx].c_str());
+				if (nbScreeningPatterns <= 0) {
+					log_cmd_error("The number of screening patterns must be positive.\n");
+				}
+				continue;
+			}
+			if (arg == "-nb-skew-patterns") {
+				if (argidx + 1 >= args.size())
+					break;
+				long long nb = std::atoll(args[++argidx].c_str());
+				if (nb <= 0) {
+					log_cmd_error("The number of skew patterns must be positive.\n");
+				}
+				nbSkewPatterns = nb;
+				continue;
+			}
+			if (arg == "-nb-threads") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbThreads = std::atoi(args[++argidx].c_str());
+				if (nbThreads < 1) {
+					log_cmd_error("The number of threads must be positive.\n");
+				}
+				continue;
+			}
+			if (arg == "-nb-reported") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbReported = std::atoi(args[++argidx].c_str());
+				continue;
+			}
 			if (arg == "-port-name") {
 				if (argidx + 1 >= args.size())
 					break;
 				port_name = args[++argidx];
 				continue;
 			}
+			if (arg == "-trace") {
+				if (argidx + 1 >= args.size())
+					break;
+				traceFile = args[++argidx];
+				continue;
+			}
 			break;
 		}
 
@@ -73,7 +129,19 @@ struct LogicLockingAnalyzePass : public Pass {
 		if (mod == NULL)
 			return;
 
-		if (key.empty()) {
+		if ((int)skew + (int)profile + (int)(nbScreeningPatterns > 0) > 1) {
+			log_cmd_error("Options -skew, -profile and -screen are mutually exclusive.\n");
+		}
+
+		TraceSession traceSession("ll_analyze", traceFile);
+
+		if (profile) {
+			report_simulation_profile(mod, nbAnalysisVectors, nbReported);
+		} else if (nbScreeningPatterns > 0) {
+			report_screening(mod, nbScreeningPatterns, nbReported);
+		} else if (skew) {
+			report_signal_skew(mod, port_name, nbSkewPatterns, nbThreads, nbReported);
+		} else if (key.empty()) {
 			std::vector<Cell *> cells = get_locked_cells(mod, solution);
 			report_locking(mod, cells, nbAnalysisKeys, nbAnalysisVectors);
 		} else if (solution.empty()) {
@@ -107,6 +175,32 @@ struct LogicLockingAnalyzePass : public Pass {
 		log("    -nb-analysis-vectors <value>\n");
 		log("        number of test vectors used (default=1024)\n");
 		log("\n");
+		log("    -skew\n");
+		log("        report the signal probability of the gates, ranked by skew and distance to the key\n");
+		log("        inputs, to find the point-function blocks of a locked design (AntiSAT, SarLock...)\n");
+		log("\n");
+		log("    -nb-skew-patterns <value>\n");
+		log("        number of random patterns used for signal probability (default=1048576)\n");
+		log("\n");
+		log("    -nb-threads <value>\n");
+		log("        number of threads used for signal probability (default=all available)\n");
+		log("\n");
+		log("    -profile\n");
+		log("        report the cost of the incremental simulation of each gate: fanout cone sizes, fraction of\n");
+		log("        simulations that do not reach an output, and the most expensive gates; the detailed counters\n");
+		log("        require a build with ENABLE_SIM_STATS=1\n");
+		log("\n");
+		log("    -screen <value>\n");
+		log("        report the output corruption caused by each gate on this number of random patterns,\n");
+		log("        simulating 64 gates at once on each pattern; for a quick screening of the candidates\n");
+		log("        -skew, -profile and -screen are mutually exclusive\n");
+		log("\n");
+		log("    -nb-reported <value>\n");
+		log("        number of gates reported for signal probability, profiling and screening (default=20)\n");
+		log("\n");
+		log("    -trace <file>\n");
+		log("        record the time spent in each phase of the pass, in Chrome trace format\n");
+		log("\n");
 		log("\n");
 		log("\n");
 	}
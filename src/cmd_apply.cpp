@@ -6,6 +6,7 @@
 
 #include "command_utils.hpp"
 #include "gate_insertion.hpp"
+#include "phase_trace.hpp"
 
 #include <limits>
 
@@ -66,6 +67,8 @@ struct LogicLockingApplyPass : public Pass {
 		if (mod == NULL)
 			return;
 
+		TraceSession trace_session("ll_apply");
+
 		std::vector<Cell *> locked_gates = get_locked_cells(mod, solution);
 		RTLIL::Wire *w = add_key_input(mod, locked_gates.size(), port_name);
 		key.erase(key.begin() + locked_gates.size(), key.end());
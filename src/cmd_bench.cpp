@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "kernel/yosys.h"
+
+#include "analysis_context.hpp"
+#include "benchmark.hpp"
+#include "command_utils.hpp"
+#include "delay_analyzer.hpp"
+#include "gate_insertion.hpp"
+#include "sat_attack.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+/// Number of random solutions cycled through by the delay benchmarks
+constexpr int nbBenchSolutions = 64;
+
+void log_result(const BenchResult &res)
+{
+	log("%s (%d nodes, %d candidates): %g %s\n", res.name.c_str(), res.nbNodes, res.nbCandidates, res.throughput, res.unit.c_str());
+}
+
+/**
+ * @brief Benchmark the delay computation, from scratch and incrementally, on random solutions
+ */
+void bench_delay(Module *mod, int nb_nodes, int nb_locked, double min_time, std::vector<BenchResult> &results)
+{
+	std::vector<Cell *> cells = get_lockable_cells(mod);
+	DelayAnalyzer delay(mod, cells);
+	std::mt19937 rgen(1);
+	std::vector<int> nodes;
+	for (int i = 0; i < GetSize(cells); ++i) {
+		nodes.push_back(i);
+	}
+	std::vector<DelayAnalyzer::Solution> solutions;
+	for (int i = 0; i < nbBenchSolutions; ++i) {
+		std::shuffle(nodes.begin(), nodes.end(), rgen);
+		solutions.emplace_back(nodes.begin(), nodes.begin() + std::min(nb_locked, GetSize(nodes)));
+	}
+
+	int next = 0;
+	results.push_back(runBench("delay", nb_nodes, GetSize(cells), "solutions/s", min_time, [&]() {
+		delay.delay(solutions[next++ % nbBenchSolutions]);
+		return 1.0;
+	}));
+	log_result(results.back());
+
+	// Successive solutions differ by a single node, as in the exploration
+	DelayAnalyzer::Solution sol = solutions[0];
+	results.push_back(runBench("incremental_delay", nb_nodes, GetSize(cells), "solutions/s", min_time, [&]() {
+		int node = rgen() % GetSize(cells);
+		if (!sol.empty() && std::find(sol.begin(), sol.end(), node) == sol.end()) {
+			sol[rgen() % sol.size()] = node;
+		}
+		delay.incrementalDelay(sol);
+		return 1.0;
+	}));
+	log_result(results.back());
+}
+
+/**
+ * @brief Benchmark the DIP loop of the Sat attack, on a copy of the module locked with random gates and key
+ */
+void bench_sat_attack(Module *mod, int nb_nodes, int nb_key_bits, double min_time, std::vector<BenchResult> &results)
+{
+	Design *design = mod->design;
+	Module *copy = design->addModule(NEW_ID);
+	mod->cloneInto(copy);
+
+	std::mt19937 rgen(1);
+	std::vector<Cell *> cells = get_lockable_cells(copy);
+	std::shuffle(cells.begin(), cells.end(), rgen);
+	cells.resize(std::min(nb_key_bits, GetSize(cells)));
+	std::vector<bool> key;
+	for (int i = 0; i < GetSize(cells); ++i) {
+		key.push_back(rgen() & 1);
+	}
+	const std::string port_name = "moosic_bench_key";
+	SigSpec key_signal(add_key_input(copy, GetSize(cells), port_name));
+	lock_gates(copy, cells, key_signal, key);
+
+	results.push_back(runBench("sat_attack_dip", nb_nodes, GetSize(cells), "dips/s", min_time, [&]() {
+		SatAttack attack(copy, port_name, key);
+		attack.runSat(0);
+		return (double)attack.nbTestVectors();
+	}));
+	log_result(results.back());
+	design->remove(copy);
+}
+
+struct LogicLockingBenchPass : public Pass {
+	LogicLockingBenchPass() : Pass("ll_bench") {}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing LOGIC_LOCKING_BENCH pass.\n");
+
+		double min_time = 0.5;
+		int nb_locked = -1;
+		int nb_key_bits = 16;
+		std::string output;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-min-time") {
+				if (argidx + 1 >= args.size())
+					break;
+				min_time = std::atof(args[++argidx].c_str());
+				if (min_time <= 0.0) {
+					log_cmd_error("The minimum time must be positive.\n");
+				}
+				continue;
+			}
+			if (arg == "-nb-locked") {
+				if (argidx + 1 >= args.size())
+					break;
+				nb_locked = std::atoi(args[++argidx].c_str());
+				if (nb_locked <= 0) {
+					log_cmd_error("The number of locked gates must be positive.\n");
+				}
+				continue;
+			}
+			if (arg == "-nb-key-bits") {
+				if (argidx + 1 >= args.size())
+					break;
+				nb_key_bits = std::atoi(args[++argidx].c_str());
+				if (nb_key_bits <= 0) {
+					log_cmd_error("The number of key bits must be positive.\n");
+				}
+				continue;
+			}
+			if (arg == "-output") {
+				if (argidx + 1 >= args.size())
+					break;
+				output = args[++argidx];
+				continue;
+			}
+			break;
+		}
+
+		// handle extra options (e.g. selection)
+		extra_args(args, argidx, design);
+
+		RTLIL::Module *mod = single_selected_module(design);
+		if (mod == NULL)
+			return;
+
+		int nb_lockable = GetSize(get_lockable_cells(mod));
+		if (nb_lockable == 0) {
+			log_cmd_error("The module has no lockable gate to benchmark.\n");
+		}
+		if (nb_locked < 0) {
+			nb_locked = std::max(1, nb_lockable / 20);
+		}
+		int nb_nodes = AnalysisContext::get_analyzer(mod).aig().nbNodes();
+
+		std::vector<BenchResult> results;
+		bench_delay(mod, nb_nodes, nb_locked, min_time, results);
+		bench_sat_attack(mod, nb_nodes, nb_key_bits, min_time, results);
+
+		std::stringstream json;
+		writeBenchJson(json, results);
+		if (output.empty()) {
+			log("%s", json.str().c_str());
+		} else {
+			std::ofstream f(output);
+			if (!f) {
+				log_cmd_error("Could not open file %s for writing.\n", output.c_str());
+			}
+			f << json.str();
+		}
+	}
+
+	void help() override
+	{
+		log("\n");
+		log("    ll_bench [options]\n");
+		log("\n");
+		log("This command runs microbenchmarks of the kernels that depend on the netlist, with\n");
+		log("the same JSON rows as moosic_bench: the delay analysis (from scratch and incremental)\n");
+		log("on random locking solutions, and the DIP loop of the Sat attack on a copy of the module\n");
+		log("locked with random gates. The Sat attack throughput includes the encoding of the design.\n");
+		log("\n");
+		log("    -min-time <seconds>\n");
+		log("        minimum time for each benchmark (default=0.5)\n");
+		log("    -nb-locked <value>\n");
+		log("        number of locked gates in the solutions for the delay analysis (default=5%% of the gates)\n");
+		log("    -nb-key-bits <value>\n");
+		log("        number of locked gates for the Sat attack (default=16)\n");
+		log("    -output <file>\n");
+		log("        write the results to this file instead of the log\n");
+		log("\n");
+	}
+} LogicLockingBenchPass;
+
+PRIVATE_NAMESPACE_END
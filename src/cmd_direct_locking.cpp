@@ -6,6 +6,7 @@
 
 #include "command_utils.hpp"
 #include "gate_insertion.hpp"
+#include "phase_trace.hpp"
 
 #include <limits>
 
@@ -65,6 +66,8 @@ struct LogicLockingDirectLockingPass : public Pass {
 		if (mod == NULL)
 			return;
 
+		TraceSession trace_session("ll_direct_locking");
+
 		int nb_xor_gates = gates_to_lock.size();
 		int nb_mux_gates = gates_to_mix.size();
 		int nb_locked = nb_xor_gates + nb_mux_gates;
@@ -4,9 +4,11 @@
 
 #include "kernel/yosys.h"
 
+#include "analysis_cache.hpp"
 #include "command_utils.hpp"
 #include "optimization.hpp"
 #include "optimization_objectives.hpp"
+#include "phase_trace.hpp"
 
 #include <chrono>
 #include <iomanip>
@@ -148,6 +150,8 @@ struct LogicLockingExplorePass : public Pass {
 		bool noEstimate = false;
 		bool compareEstimate = false;
 		bool plot = false;
+		bool preferDelayNeutral = false;
+		std::string traceFile;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -198,6 +202,10 @@ struct LogicLockingExplorePass : public Pass {
 				objectives.push_back(ObjectiveType::PairwiseSecurity);
 				continue;
 			}
+			if (arg == "-analytic-corruptibility") {
+				objectives.push_back(ObjectiveType::AnalyticCorruptibility);
+				continue;
+			}
 			if (arg == "-no-estimate") {
 				noEstimate = true;
 				continue;
@@ -207,6 +215,10 @@ struct LogicLockingExplorePass : public Pass {
 				compareEstimate = true;
 				continue;
 			}
+			if (arg == "-prefer-delay-neutral") {
+				preferDelayNeutral = true;
+				continue;
+			}
 			if (arg == "-plot") {
 				plot = true;
 				continue;
@@ -229,6 +241,18 @@ struct LogicLockingExplorePass : public Pass {
 				}
 				continue;
 			}
+			if (arg == "-cache-dir") {
+				if (argidx + 1 >= args.size())
+					break;
+				AnalysisCache::set_directory(args[++argidx]);
+				continue;
+			}
+			if (arg == "-trace") {
+				if (argidx + 1 >= args.size())
+					break;
+				traceFile = args[++argidx];
+				continue;
+			}
 			break;
 		}
 
@@ -274,12 +298,19 @@ struct LogicLockingExplorePass : public Pass {
 		if (mod == NULL)
 			return;
 
+		TraceSession traceSession("ll_explore", traceFile);
+
 		// Now execute the optimization itself
 		Optimizer opt(mod, get_lockable_cells(mod), objectives, nbAnalysisVectors / 64, nbAnalysisKeys);
 		if (!opt.hasObjective(ObjectiveType::Area) && !opt.hasObjective(ObjectiveType::Delay)) {
 			log_cmd_error("You should use at least the area or delay objective.\n");
 		}
 
+		if (preferDelayNeutral) {
+			int nbNeutral = opt.preferDelayNeutralMoves();
+			log("%d cells out of %d can be locked without increasing the delay.\n", nbNeutral, opt.nbNodes());
+		}
+
 		run_optimization(opt, iterLimit, timeLimit);
 		report_optimization(opt, std::cout, true);
 		if (output != "") {
@@ -307,6 +338,8 @@ struct LogicLockingExplorePass : public Pass {
 		log("        csv file to report the results\n");
 		log("    -plot\n");
 		log("        plot the results (uses Gnuplot)\n");
+		log("    -prefer-delay-neutral\n");
+		log("        favour moves that lock cells with enough slack not to increase the delay\n");
 		log("\n");
 		log("These options control the optimization objectives that are enabled:\n");
 		log("    -area\n");
@@ -323,6 +356,9 @@ struct LogicLockingExplorePass : public Pass {
 		log("        enable corruption optimization\n");
 		log("    -pairwise-security\n");
 		log("        enable pairwise security optimization\n");
+		log("    -analytic-corruptibility\n");
+		log("        enable optimization of an analytic estimate of test corruptibility, computed without\n");
+		log("        simulation from signal probabilities and observabilities (COP); for very large designs\n");
 		log("\n");
 		log("These options control analysis of the logic locking solution's security:\n");
 		log("    -nb-analysis-keys <value>\n");
@@ -331,7 +367,11 @@ struct LogicLockingExplorePass : public Pass {
 		log("        number of test vectors used (default=1024)\n");
 		log("    -no-estimate\n");
 		log("        use full computation for corruptibility objectives\n");
+		log("    -cache-dir <directory>\n");
+		log("        store the analyses of the module in this directory, and reuse them in later runs on the same netlist\n");
 		log("\n");
+		log("    -trace <file>\n");
+		log("        record the time spent in each phase of the pass, in Chrome trace format\n");
 		log("\n");
 		log("\n");
 	}
@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "kernel/yosys.h"
+
+#include "phase_trace.hpp"
+
+#include <array>
+#include <random>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+/**
+ * @brief Shape of the generated netlist
+ */
+struct GeneratorOptions {
+	int nb_gates = 1000;
+	int nb_inputs = 32;
+	int nb_outputs = 32;
+	int nb_flops = 0;
+	int depth = 20;
+	int max_fanout = 0;
+	double reconvergence = 0.2;
+	double mux_ratio = 0.1;
+	double xor_ratio = 0.15;
+	std::uint64_t seed = 1;
+};
+
+/**
+ * @brief Random generator of gate-level netlists, organized in levels
+ *
+ * Sources (primary inputs and flip-flop outputs) form level 0; each gate takes its first input from
+ * the previous level, which fixes the depth of the netlist, and its other inputs from any earlier level.
+ * Reconvergence is obtained by taking an input among the transitive fanin of the first one.
+ */
+class NetlistGenerator
+{
+      public:
+	NetlistGenerator(Module *module, const GeneratorOptions &opt) : module_(module), opt_(opt), rgen_(opt.seed) {}
+
+	void run()
+	{
+		create_sources();
+		create_gates();
+		create_sinks();
+		module_->fixup_ports();
+	}
+
+      private:
+	enum GateType { AND, NAND, OR, NOR, XOR, XNOR, NOT, MUX };
+
+	void create_sources()
+	{
+		Wire *in = module_->addWire(ID(in), opt_.nb_inputs);
+		in->port_input = true;
+		for (int i = 0; i < opt_.nb_inputs; ++i) {
+			add_signal(SigBit(in, i));
+		}
+		if (opt_.nb_flops > 0) {
+			Wire *clk = module_->addWire(ID(clk));
+			clk->port_input = true;
+			clk_ = clk;
+			flop_q_ = module_->addWire(ID(q), opt_.nb_flops);
+			for (int i = 0; i < opt_.nb_flops; ++i) {
+				add_signal(SigBit(flop_q_, i));
+			}
+		}
+		level_start_.push_back(0);
+		level_start_.push_back(GetSize(signals_));
+	}
+
+	void create_gates()
+	{
+		Wire *n = module_->addWire(ID(n), opt_.nb_gates);
+		int gate = 0;
+		for (int level = 1; level <= opt_.depth; ++level) {
+			// Spread the gates evenly over the levels
+			int level_end = (int)((long long)opt_.nb_gates * level / opt_.depth);
+			for (; gate < level_end; ++gate) {
+				create_gate(gate, level, SigBit(n, gate));
+			}
+			level_start_.push_back(GetSize(signals_));
+		}
+	}
+
+	void create_gate(int gate, int level, SigBit y)
+	{
+		GateType type = pick_type();
+		int nb_fanins = type == MUX ? 3 : type == NOT ? 1 : 2;
+		std::array<int, 3> fanins = {-1, -1, -1};
+		fanins[0] = pick_signal(level_start_[level - 1], level_start_[level]);
+		for (int i = 1; i < nb_fanins; ++i) {
+			fanins[i] = pick_second_fanin(fanins[0], level);
+		}
+		for (int i = 0; i < nb_fanins; ++i) {
+			++fanout_[fanins[i]];
+		}
+		IdString name = stringf("\\g%d", gate);
+		SigBit a = signals_[fanins[0]];
+		SigBit b = nb_fanins > 1 ? signals_[fanins[1]] : SigBit();
+		switch (type) {
+		case AND:
+			module_->addAndGate(name, a, b, y);
+			break;
+		case NAND:
+			module_->addNandGate(name, a, b, y);
+			break;
+		case OR:
+			module_->addOrGate(name, a, b, y);
+			break;
+		case NOR:
+			module_->addNorGate(name, a, b, y);
+			break;
+		case XOR:
+			module_->addXorGate(name, a, b, y);
+			break;
+		case XNOR:
+			module_->addXnorGate(name, a, b, y);
+			break;
+		case NOT:
+			module_->addNotGate(name, a, y);
+			break;
+		case MUX:
+			module_->addMuxGate(name, a, b, signals_[fanins[2]], y);
+			break;
+		}
+		add_signal(y, fanins);
+	}
+
+	/**
+	 * @brief Create the primary outputs and the flip-flop inputs, preferring signals that are not used yet
+	 */
+	void create_sinks()
+	{
+		int first_gate = level_start_[0] + opt_.nb_inputs + opt_.nb_flops;
+		std::vector<int> unused;
+		for (int i = first_gate; i < GetSize(signals_); ++i) {
+			if (fanout_[i] == 0) {
+				unused.push_back(i);
+			}
+		}
+		// Unused gates from the last levels are used first, for the outputs
+		auto pick_sink = [&]() {
+			if (!unused.empty()) {
+				int ret = unused.back();
+				unused.pop_back();
+				return ret;
+			}
+			return pick_signal(first_gate, GetSize(signals_));
+		};
+
+		Wire *out = module_->addWire(ID(out), opt_.nb_outputs);
+		out->port_output = true;
+		SigSpec out_sig;
+		for (int i = 0; i < opt_.nb_outputs; ++i) {
+			out_sig.append(signals_[pick_sink()]);
+		}
+		module_->connect(out, out_sig);
+
+		for (int i = 0; i < opt_.nb_flops; ++i) {
+			module_->addDffGate(stringf("\\ff%d", i), clk_, signals_[pick_sink()], SigBit(flop_q_, i));
+		}
+	}
+
+	GateType pick_type()
+	{
+		double r = std::uniform_real_distribution<double>()(rgen_);
+		if (r < opt_.mux_ratio) {
+			return MUX;
+		}
+		r -= opt_.mux_ratio;
+		if (r < opt_.xor_ratio) {
+			return std::uniform_int_distribution<int>(0, 1)(rgen_) ? XOR : XNOR;
+		}
+		static const GateType others[] = {AND, AND, NAND, NAND, OR, OR, NOR, NOR, NOT};
+		return others[std::uniform_int_distribution<int>(0, 8)(rgen_)];
+	}
+
+	/**
+	 * @brief Pick a signal in the range, avoiding the ones that reached the maximum fanout if possible
+	 */
+	int pick_signal(int begin, int end)
+	{
+		std::uniform_int_distribution<int> dist(begin, end - 1);
+		int ret = dist(rgen_);
+		for (int attempt = 0; opt_.max_fanout > 0 && fanout_[ret] >= opt_.max_fanout && attempt < 8; ++attempt) {
+			ret = dist(rgen_);
+		}
+		return ret;
+	}
+
+	int pick_second_fanin(int first, int level)
+	{
+		if (fanins_[first][0] >= 0 && std::uniform_real_distribution<double>()(rgen_) < opt_.reconvergence) {
+			// Walk back a few levels in the transitive fanin of the first input to create a reconvergent path
+			int cur = first;
+			int steps = std::uniform_int_distribution<int>(1, 3)(rgen_);
+			for (int i = 0; i < steps && fanins_[cur][0] >= 0; ++i) {
+				int nb_fanins = fanins_[cur][2] >= 0 ? 3 : fanins_[cur][1] >= 0 ? 2 : 1;
+				cur = fanins_[cur][std::uniform_int_distribution<int>(0, nb_fanins - 1)(rgen_)];
+			}
+			return cur;
+		}
+		return pick_signal(0, level_start_[level]);
+	}
+
+	void add_signal(SigBit bit, std::array<int, 3> fanins = {-1, -1, -1})
+	{
+		signals_.push_back(bit);
+		fanins_.push_back(fanins);
+		fanout_.push_back(0);
+	}
+
+      private:
+	Module *module_;
+	GeneratorOptions opt_;
+	std::mt19937_64 rgen_;
+	Wire *clk_ = nullptr;
+	Wire *flop_q_ = nullptr;
+
+	/// Driver bit of each signal (sources, then gates in level order)
+	std::vector<SigBit> signals_;
+	/// Fanins of each signal, -1 if unused
+	std::vector<std::array<int, 3>> fanins_;
+	/// Number of gates using each signal
+	std::vector<int> fanout_;
+	/// Index of the first signal of each level
+	std::vector<int> level_start_;
+};
+
+struct LogicLockingGeneratePass : public Pass {
+	LogicLockingGeneratePass() : Pass("ll_gen") {}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing LOGIC_LOCKING_GEN pass.\n");
+
+		GeneratorOptions opt;
+		std::string name = "gen";
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-nb-gates") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.nb_gates = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-nb-inputs") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.nb_inputs = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-nb-outputs") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.nb_outputs = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-nb-flops") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.nb_flops = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-depth") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.depth = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-max-fanout") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.max_fanout = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-reconvergence") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.reconvergence = std::atof(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-mux-ratio") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.mux_ratio = std::atof(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-xor-ratio") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.xor_ratio = std::atof(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-seed") {
+				if (argidx + 1 >= args.size())
+					break;
+				opt.seed = std::atoll(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-name") {
+				if (argidx + 1 >= args.size())
+					break;
+				name = args[++argidx];
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (opt.nb_gates < 1 || opt.nb_inputs < 1 || opt.nb_outputs < 1 || opt.nb_flops < 0) {
+			log_cmd_error("The number of gates, inputs and outputs must be positive.\n");
+		}
+		if (opt.depth < 1 || opt.depth > opt.nb_gates) {
+			log_cmd_error("The depth must be between 1 and the number of gates.\n");
+		}
+		if (opt.reconvergence < 0.0 || opt.reconvergence > 1.0) {
+			log_cmd_error("The reconvergence must be between 0 and 1.\n");
+		}
+		if (opt.mux_ratio < 0.0 || opt.xor_ratio < 0.0 || opt.mux_ratio + opt.xor_ratio > 1.0) {
+			log_cmd_error("The mux and xor ratios must be positive and sum to at most 1.\n");
+		}
+		IdString module_name = RTLIL::escape_id(name);
+		if (design->module(module_name) != nullptr) {
+			log_cmd_error("Module %s already exists.\n", log_id(module_name));
+		}
+
+		TraceSession trace_session("ll_gen");
+		Module *module = design->addModule(module_name);
+		NetlistGenerator gen(module, opt);
+		gen.run();
+		log("Generated module %s with %d inputs, %d outputs, %d flip-flops and %d gates over %d levels.\n", log_id(module_name),
+		    opt.nb_inputs, opt.nb_outputs, opt.nb_flops, opt.nb_gates, opt.depth);
+	}
+
+	void help() override
+	{
+		log("\n");
+		log("    ll_gen [options]\n");
+		log("\n");
+		log("This command generates a random gate-level module, to evaluate the logic locking algorithms on\n");
+		log("netlists of controlled size and shape. The result only depends on the options and the seed.\n");
+		log("Gates are organized in levels: each gate takes an input from the previous level and the others\n");
+		log("from earlier levels, or from its own transitive fanin to create reconvergent paths.\n");
+		log("\n");
+		log("    -nb-gates <value>\n");
+		log("        number of gates (default=1000)\n");
+		log("\n");
+		log("    -nb-inputs <value>\n");
+		log("        number of primary inputs (default=32)\n");
+		log("\n");
+		log("    -nb-outputs <value>\n");
+		log("        number of primary outputs (default=32)\n");
+		log("\n");
+		log("    -nb-flops <value>\n");
+		log("        number of flip-flops; the module is combinational if zero (default=0)\n");
+		log("\n");
+		log("    -depth <value>\n");
+		log("        number of logic levels (default=20)\n");
+		log("\n");
+		log("    -max-fanout <value>\n");
+		log("        fanout limit for the signals, not enforced if zero (default=0)\n");
+		log("\n");
+		log("    -reconvergence <value>\n");
+		log("        probability of creating a reconvergent path for each additional gate input (default=0.2)\n");
+		log("\n");
+		log("    -mux-ratio <value>\n");
+		log("        proportion of multiplexers (default=0.1)\n");
+		log("\n");
+		log("    -xor-ratio <value>\n");
+		log("        proportion of xor and xnor gates (default=0.15)\n");
+		log("\n");
+		log("    -seed <value>\n");
+		log("        seed of the random generator (default=1)\n");
+		log("\n");
+		log("    -name <value>\n");
+		log("        name of the generated module (default=gen)\n");
+		log("\n");
+		log("\n");
+	}
+} LogicLockingGeneratePass;
+
+PRIVATE_NAMESPACE_END
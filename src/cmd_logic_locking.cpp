@@ -9,13 +9,17 @@
 
 #include <boost/filesystem.hpp>
 
+#include "analysis_cache.hpp"
+#include "analysis_context.hpp"
 #include "antisat.hpp"
 #include "command_utils.hpp"
+#include "delay_analyzer.hpp"
 #include "gate_insertion.hpp"
 #include "mini_aig.hpp"
 #include "optimization.hpp"
 #include "output_corruption_optimizer.hpp"
 #include "pairwise_security_optimizer.hpp"
+#include "phase_trace.hpp"
 
 #include <cstdlib>
 
@@ -25,13 +29,13 @@ PRIVATE_NAMESPACE_BEGIN
 /**
  * @brief Run the optimization algorithm to maximize pairwise security
  */
-std::vector<Cell *> optimize_pairwise_security(LogicLockingAnalyzer &pw, bool ignore_duplicates, int maxNumber)
+std::vector<Cell *> optimize_pairwise_security(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, bool ignore_duplicates, int maxNumber)
 {
-	std::vector<Cell *> cells = pw.get_lockable_cells();
 	auto opt = pw.analyze_pairwise_security(cells, ignore_duplicates);
 
 	log("Running optimization on the interference graph with %d non-trivial nodes out of %d and %d edges.\n", opt.nbConnectedNodes(),
 	    opt.nbNodes(), opt.nbEdges());
+	TraceScope trace("greedy");
 	auto sol = opt.solveGreedy(maxNumber);
 
 	std::vector<Cell *> ret;
@@ -43,6 +47,9 @@ std::vector<Cell *> optimize_pairwise_security(LogicLockingAnalyzer &pw, bool ig
 		}
 	}
 
+	trace.addCounter("locked", ret.size());
+	trace.addCounter("cliques", sol.size());
+
 	double security = opt.value(sol);
 	log("Locking solution with %d cliques, %d locked wires and %.1f estimated security. Max clique was %d.\n", (int)sol.size(), (int)ret.size(),
 	    security, max_clique);
@@ -52,13 +59,14 @@ std::vector<Cell *> optimize_pairwise_security(LogicLockingAnalyzer &pw, bool ig
 /**
  * @brief Run the optimization algorithm to maximize output corruption
  */
-std::vector<Cell *> optimize_output_corruption(LogicLockingAnalyzer &pw, int maxNumber)
+std::vector<Cell *> optimize_output_corruption(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber)
 {
-	std::vector<Cell *> cells = pw.get_lockable_cells();
 	auto opt = pw.analyze_corruptibility(cells);
 
 	log("Running corruption optimization with %d unique nodes out of %d.\n", (int)opt.getUniqueNodes().size(), opt.nbNodes());
+	TraceScope trace("greedy");
 	std::vector<int> sol = opt.solveGreedy(maxNumber, std::vector<int>());
+	trace.addCounter("locked", sol.size());
 	float cover = 100.0 * opt.corruptibility(sol);
 	float rate = 100.0 * opt.corruptionSum(sol);
 
@@ -71,18 +79,82 @@ std::vector<Cell *> optimize_output_corruption(LogicLockingAnalyzer &pw, int max
 	return ret;
 }
 
+/**
+ * @brief Parse the delay budget, either absolute (3) or as percentage of the original delay (5%)
+ */
+int parse_max_delay_increase(const std::string &arg, int base_delay)
+{
+	if (arg.empty()) {
+		return 0;
+	}
+	std::string number = arg;
+	bool percentage = number.back() == '%';
+	if (percentage) {
+		number.pop_back();
+	}
+	char *end = nullptr;
+	double value = percentage ? std::strtod(number.c_str(), &end) : std::strtol(number.c_str(), &end, 10);
+	if (number.empty() || *end != '\0') {
+		log_cmd_error("Invalid maximum delay increase %s: expected an integer or a percentage.\n", arg.c_str());
+	}
+	if (value < 0.0) {
+		log_cmd_error("Maximum delay increase should be non-negative.\n");
+	}
+	return percentage ? static_cast<int>(0.01 * base_delay * value) : static_cast<int>(value);
+}
+
+/**
+ * @brief Run the optimization algorithm to maximize output corruption while keeping the delay within a budget
+ */
+std::vector<Cell *> optimize_timing_corruption(RTLIL::Module *mod, LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber,
+					       const std::string &maxDelayIncrease)
+{
+	auto opt = pw.analyze_corruptibility(cells);
+	DelayAnalyzer delay(mod, cells);
+	int baseDelay = delay.currentDelay();
+	int maxDelay = baseDelay + parse_max_delay_increase(maxDelayIncrease, baseDelay);
+
+	log("Running timing-driven corruption optimization with %d unique nodes out of %d, and maximum delay %d (originally %d).\n",
+	    (int)opt.getUniqueNodes().size(), opt.nbNodes(), maxDelay, baseDelay);
+	int nbRejected = 0;
+	auto accept = [&](int node) {
+		// Locking only adds delay, so a rejected node would never fit in the budget later
+		if (delay.delayWithLocking(node) > maxDelay) {
+			++nbRejected;
+			return false;
+		}
+		delay.addLocking(node);
+		return true;
+	};
+	TraceScope trace("greedy");
+	std::vector<int> sol = opt.solveGreedyConstrained(maxNumber, accept);
+	trace.addCounter("locked", sol.size());
+	trace.addCounter("rejected", nbRejected);
+	float cover = 100.0 * opt.corruptibility(sol);
+	float rate = 100.0 * opt.corruptionSum(sol);
+
+	log("Locking solution with %d locked wires, %.1f%% estimated corruptibility and %.1f%% secondary objective.\n", (int)sol.size(), cover, rate);
+	log("Delay increased from %d to %d; %d nodes rejected because of the delay budget.\n", baseDelay, delay.currentDelay(), nbRejected);
+
+	std::vector<Cell *> ret;
+	for (int c : sol) {
+		ret.push_back(cells[c]);
+	}
+	return ret;
+}
+
 /**
  * @brief Run the optimization algorithm to obtain a tradeoff between pairwise security and output corruption
  */
-std::vector<Cell *> optimize_hybrid(LogicLockingAnalyzer &pw, int maxNumber)
+std::vector<Cell *> optimize_hybrid(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber)
 {
-	std::vector<Cell *> cells = pw.get_lockable_cells();
 	auto corr = pw.analyze_corruptibility(cells);
 	auto pairw = pw.analyze_pairwise_security(cells, true);
 
 	log("Running hybrid optimization\n");
 	log("Interference graph with %d non-trivial nodes out of %d and %d edges.\n", pairw.nbConnectedNodes(), pairw.nbNodes(), pairw.nbEdges());
 	log("Corruption data with %d unique nodes out of %d.\n", (int)corr.getUniqueNodes().size(), corr.nbNodes());
+	TraceScope trace("greedy");
 	auto pairwSol = pairw.solveGreedy(maxNumber);
 	std::vector<int> largestClique;
 	if (!pairwSol.empty() && pairwSol.front().size() > 1) {
@@ -90,6 +162,7 @@ std::vector<Cell *> optimize_hybrid(LogicLockingAnalyzer &pw, int maxNumber)
 	}
 
 	std::vector<int> sol = corr.solveGreedy(maxNumber, largestClique);
+	trace.addCounter("locked", sol.size());
 	float cover = 100.0 * corr.corruptibility(sol);
 	float rate = 100.0 * corr.corruptionSum(sol);
 
@@ -137,9 +210,8 @@ std::vector<Cell *> select_best_cells(const std::vector<Cell *> &cells, const st
  * @brief Run the optimization algorithm to maximize FLL fault impact, as defined by the paper
  * Fault Analysis-based Logic Encryption.
  */
-std::vector<Cell *> optimize_FLL(LogicLockingAnalyzer &pw, int maxNumber)
+std::vector<Cell *> optimize_FLL(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber)
 {
-	std::vector<Cell *> cells = pw.get_lockable_cells();
 	std::vector<double> metric = pw.compute_FLL(cells);
 	return select_best_cells(cells, metric, maxNumber, false);
 }
@@ -148,13 +220,42 @@ std::vector<Cell *> optimize_FLL(LogicLockingAnalyzer &pw, int maxNumber)
  * @brief Run the optimization algorithm to maximize KIP fault impact, as defined by the Phd thesis
  * Hardware Trust: Design Solutions for Logic Locking by Quang-Linh Nguyen
  */
-std::vector<Cell *> optimize_KIP(LogicLockingAnalyzer &pw, int maxNumber)
+std::vector<Cell *> optimize_KIP(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber)
 {
-	std::vector<Cell *> cells = pw.get_lockable_cells();
 	std::vector<double> metric = pw.compute_KIP(cells);
 	return select_best_cells(cells, metric, maxNumber, true);
 }
 
+/**
+ * @brief Select the cells with the highest analytic (COP) observability, without simulation, for very large designs
+ */
+std::vector<Cell *> optimize_analytic(LogicLockingAnalyzer &pw, const std::vector<Cell *> &cells, int maxNumber)
+{
+	TraceScope trace("greedy");
+	std::vector<double> metric = pw.compute_cop_observability(cells);
+	std::vector<Cell *> ret = select_best_cells(cells, metric, maxNumber, false);
+	trace.addCounter("locked", ret.size());
+	return ret;
+}
+
+/**
+ * @brief Keep only the cells that can be locked without increasing the delay of the design
+ */
+std::vector<Cell *> filter_delay_neutral(RTLIL::Module *mod, const std::vector<Cell *> &cells)
+{
+	DelayAnalyzer delay(mod, cells);
+	std::vector<char> mask = delay.delayNeutralMask();
+	std::vector<Cell *> ret;
+	for (int i = 0; i < GetSize(cells); ++i) {
+		if (mask[i]) {
+			ret.push_back(cells[i]);
+		}
+	}
+	log("Restricting locking to %d cells out of %d that do not increase the delay (critical delay %d).\n", GetSize(ret), GetSize(cells),
+	    delay.currentDelay());
+	return ret;
+}
+
 /**
  * @brief Just return the design outputs
  */
@@ -175,27 +276,36 @@ std::vector<Cell *> optimize_outputs(LogicLockingAnalyzer &pw)
 /**
  * @brief Run the logic locking algorithm and return the cells to be locked
  */
-std::vector<Cell *> run_logic_locking(RTLIL::Module *mod, int nb_test_vectors, int nb_locked, OptimizationTarget target)
+std::vector<Cell *> run_logic_locking(RTLIL::Module *mod, int nb_test_vectors, int nb_locked, OptimizationTarget target, bool delay_neutral,
+				      const std::string &max_delay_increase)
 {
 	if (target != OptimizationTarget::Outputs) {
 		log("Running logic locking with %d test vectors, locking %d cells out of %d.\n", nb_test_vectors, nb_locked, GetSize(mod->cells_));
 	}
-	LogicLockingAnalyzer pw(mod);
-	pw.gen_test_vectors(nb_test_vectors / 64, 1);
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(mod, nb_test_vectors / 64);
+
+	std::vector<Cell *> cells = pw.get_lockable_cells();
+	if (delay_neutral && target != OptimizationTarget::Outputs) {
+		cells = filter_delay_neutral(mod, cells);
+	}
 
 	std::vector<Cell *> locked_gates;
 	if (target == OptimizationTarget::PairwiseSecurity) {
-		locked_gates = optimize_pairwise_security(pw, true, nb_locked);
+		locked_gates = optimize_pairwise_security(pw, cells, true, nb_locked);
 	} else if (target == OptimizationTarget::PairwiseSecurityNoDedup) {
-		locked_gates = optimize_pairwise_security(pw, false, nb_locked);
+		locked_gates = optimize_pairwise_security(pw, cells, false, nb_locked);
 	} else if (target == OptimizationTarget::OutputCorruption) {
-		locked_gates = optimize_output_corruption(pw, nb_locked);
+		locked_gates = optimize_output_corruption(pw, cells, nb_locked);
+	} else if (target == OptimizationTarget::TimingCorruption) {
+		locked_gates = optimize_timing_corruption(mod, pw, cells, nb_locked, max_delay_increase);
 	} else if (target == OptimizationTarget::Hybrid) {
-		locked_gates = optimize_hybrid(pw, nb_locked);
+		locked_gates = optimize_hybrid(pw, cells, nb_locked);
 	} else if (target == OptimizationTarget::FaultAnalysisFll) {
-		locked_gates = optimize_FLL(pw, nb_locked);
+		locked_gates = optimize_FLL(pw, cells, nb_locked);
 	} else if (target == OptimizationTarget::FaultAnalysisKip) {
-		locked_gates = optimize_KIP(pw, nb_locked);
+		locked_gates = optimize_KIP(pw, cells, nb_locked);
+	} else if (target == OptimizationTarget::AnalyticCorruption) {
+		locked_gates = optimize_analytic(pw, cells, nb_locked);
 	} else if (target == OptimizationTarget::Outputs) {
 		locked_gates = optimize_outputs(pw);
 	} else {
@@ -243,12 +353,16 @@ OptimizationTarget parseOptimizationTarget(const std::string &t)
 		return OptimizationTarget::PairwiseSecurityNoDedup;
 	} else if (t == "corruption") {
 		return OptimizationTarget::OutputCorruption;
+	} else if (t == "timing-corruption" || t == "timing") {
+		return OptimizationTarget::TimingCorruption;
 	} else if (t == "hybrid") {
 		return OptimizationTarget::Hybrid;
 	} else if (t == "fault-analysis-fll" || t == "fll") {
 		return OptimizationTarget::FaultAnalysisFll;
 	} else if (t == "fault-analysis-kip" || t == "kip") {
 		return OptimizationTarget::FaultAnalysisKip;
+	} else if (t == "analytic") {
+		return OptimizationTarget::AnalyticCorruption;
 	} else if (t == "outputs") {
 		return OptimizationTarget::Outputs;
 	} else {
@@ -284,12 +398,15 @@ struct LogicLockingPass : public Pass {
 		SatCountermeasure antisat = SatCountermeasure::None;
 		std::string nb_locked_str;
 		std::string nb_antisat_str;
+		std::string max_delay_increase;
 		int nb_test_vectors = 64;
 		int nb_analysis_keys = 128;
 		int nb_analysis_vectors = 1024;
 		bool dry_run = false;
+		bool delay_neutral = false;
 		std::string port_name = "moosic_key";
 		std::string key;
+		std::string trace_file;
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
 			std::string arg = args[argidx];
@@ -359,20 +476,49 @@ struct LogicLockingPass : public Pass {
 				}
 				continue;
 			}
+			if (arg == "-max-delay-increase") {
+				if (argidx + 1 >= args.size())
+					break;
+				max_delay_increase = args[++argidx];
+				// Check the syntax now, before the analyses
+				parse_max_delay_increase(max_delay_increase, 0);
+				continue;
+			}
+			if (arg == "-delay-neutral") {
+				delay_neutral = true;
+				continue;
+			}
 			if (arg == "-dry-run") {
 				dry_run = true;
 				continue;
 			}
+			if (arg == "-cache-dir") {
+				if (argidx + 1 >= args.size())
+					break;
+				AnalysisCache::set_directory(args[++argidx]);
+				continue;
+			}
+			if (arg == "-trace") {
+				if (argidx + 1 >= args.size())
+					break;
+				trace_file = args[++argidx];
+				continue;
+			}
 			break;
 		}
 
 		// handle extra options (e.g. selection)
 		extra_args(args, argidx, design);
 
+		if (!max_delay_increase.empty() && target != OptimizationTarget::TimingCorruption) {
+			log_cmd_error("Option -max-delay-increase is only supported with -target timing.\n");
+		}
+
 		RTLIL::Module *mod = single_selected_module(design);
 		if (mod == NULL)
 			return;
 
+		TraceSession trace_session("logic_locking", trace_file);
 		int nb_locked = parseOptionalPercentage(mod, nb_locked_str, 5.0);
 		int nb_antisat = parseOptionalPercentage(mod, nb_antisat_str, 5.0);
 
@@ -389,7 +535,7 @@ struct LogicLockingPass : public Pass {
 		 * This would give more targets for locking, as primary inputs are not considered
 		 * right now.
 		 */
-		auto locked_gates = run_logic_locking(mod, nb_test_vectors, nb_locked, target);
+		auto locked_gates = run_logic_locking(mod, nb_test_vectors, nb_locked, target, delay_neutral, max_delay_increase);
 
 		report_locking(mod, locked_gates, nb_analysis_keys, nb_analysis_vectors);
 
@@ -417,6 +563,10 @@ struct LogicLockingPass : public Pass {
 			return;
 		}
 
+		TraceScope trace("gate_insertion");
+		trace.addCounter("locked", nb_locked);
+		trace.addCounter("antisat", nb_antisat);
+
 		// Instanciate locking
 		// WARNING: Modifies the module
 		SigSpec lock_signal(mod->addWire(NEW_ID, nb_locked));
@@ -469,12 +619,28 @@ struct LogicLockingPass : public Pass {
 		log("\n");
 		log("\n");
 		log("The following options control the optimization algorithms to insert key gates.\n");
-		log("    -target {corruption|pairwise|hybrid|fll|kip|outputs}\n");
-		log("        optimization target for locking (default=corruption)\n");
+		log("    -target {corruption|timing|pairwise|hybrid|fll|kip|analytic|outputs}\n");
+		log("        optimization target for locking (default=corruption); analytic ranks the cells by\n");
+		log("        their estimated observability, without simulation, for very large designs\n");
 		log("\n");
 		log("    -nb-test-vectors <value>\n");
 		log("        number of test vectors used for analysis during optimization (default=64)\n");
 		log("\n");
+		log("    -max-delay-increase <value>\n");
+		log("        delay budget for the timing target, either absolute (2) or as percentage of the delay (5.0%%) (default=0);\n");
+		log("        only valid with -target timing\n");
+		log("\n");
+		log("    -delay-neutral\n");
+		log("        only lock cells with enough slack that locking them alone does not increase the delay\n");
+		log("\n");
+		log("    -cache-dir <directory>\n");
+		log("        store the Aig, corruption and pairwise security analyses of the module in this directory,\n");
+		log("        and reuse them in later runs on the same netlist; the cache stays enabled for the next passes\n");
+		log("\n");
+		log("    -trace <file>\n");
+		log("        record the time spent in each phase of the pass, in Chrome trace format (chrome://tracing);\n");
+		log("        the MOOSIC_TRACE environment variable enables the trace for all passes\n");
+		log("\n");
 		log("\n");
 		log("These options control the security metrics analysis.\n");
 		log("    -nb-analysis-keys <value>\n");
@@ -487,6 +653,8 @@ struct LogicLockingPass : public Pass {
 		log("  * Target \"corruption\" maximizes the impact of the locked signals on the outputs.\n");
 		log("It will chose signals that cause changes in as many outputs for as many \n");
 		log("test vectors as possible.\n");
+		log("  * Target \"timing\" maximizes corruption like \"corruption\", but skips signals whose locking\n");
+		log("would increase the delay of the design beyond the budget given by -max-delay-increase.\n");
 		log("  * Target \"pairwise\" maximizes the number of mutually pairwise-secure signals.\n");
 		log("Two signals are pairwise secure if the value of the locking key for one of them \n");
 		log("cannot be recovered just by controlling the inputs, independently of the other.\n");
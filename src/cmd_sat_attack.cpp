@@ -2,6 +2,7 @@
  * Copyright (c) 2023-2024 Gabriel Gouvine
  */
 
+#include "phase_trace.hpp"
 #include "sat_attack.hpp"
 
 USING_YOSYS_NAMESPACE
@@ -21,7 +22,13 @@ struct LogicLockingSatAttackPass : public Pass {
 		double timeLimit = std::numeric_limits<double>::infinity();
 		std::string portName = "moosic_key";
 		std::string cnfFile = "";
+		std::string checkpointFile = "";
+		std::string telemetryFile = "";
+		std::string resumeFile = "";
+		double checkpointInterval = 60.0;
 		std::string key;
+		bool decompose = false;
+		std::string traceFile;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -74,12 +81,46 @@ struct LogicLockingSatAttackPass : public Pass {
 				portName = args[++argidx];
 				continue;
 			}
+			if (arg == "-telemetry") {
+				if (argidx + 1 >= args.size())
+					break;
+				telemetryFile = args[++argidx];
+				continue;
+			}
+			if (arg == "-checkpoint") {
+				if (argidx + 1 >= args.size())
+					break;
+				checkpointFile = args[++argidx];
+				continue;
+			}
+			if (arg == "-checkpoint-interval") {
+				if (argidx + 1 >= args.size())
+					break;
+				checkpointInterval = atof(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-resume") {
+				if (argidx + 1 >= args.size())
+					break;
+				resumeFile = args[++argidx];
+				continue;
+			}
+			if (arg == "-decompose") {
+				decompose = true;
+				continue;
+			}
 			if (arg == "-cnf-file") {
 				if (argidx + 1 >= args.size())
 					break;
 				cnfFile = args[++argidx];
 				continue;
 			}
+			if (arg == "-trace") {
+				if (argidx + 1 >= args.size())
+					break;
+				traceFile = args[++argidx];
+				continue;
+			}
 			break;
 		}
 
@@ -91,14 +132,25 @@ struct LogicLockingSatAttackPass : public Pass {
 		if (mod == NULL)
 			return;
 
-		if (nbInitialVectors < 0 || nbDIQueries < 1 || nbTestVectors < 1 || settleThreshold < 1 || errorThreshold < 0.0) {
+		TraceSession traceSession("ll_sat_attack", traceFile);
+
+		if (nbInitialVectors < 0 || nbDIQueries < 1 || nbTestVectors < 1 || settleThreshold < 1 || errorThreshold < 0.0 ||
+		    checkpointInterval < 0.0) {
 			log_cmd_error("Invalid option value.\n");
 		}
+		if (decompose && (!checkpointFile.empty() || !resumeFile.empty())) {
+			log_cmd_error("Checkpoints are not supported with the -decompose option.\n");
+		}
 
 		SatAttack attack(mod, portName, key_values);
 		attack.setTimeLimit(timeLimit);
 		attack.setCnfFile(cnfFile);
-		if (errorThreshold <= 0.0) {
+		attack.setCheckpointFile(checkpointFile, checkpointInterval);
+		attack.setResumeFile(resumeFile);
+		attack.setTelemetryFile(telemetryFile);
+		if (decompose) {
+			attack.runDecomposed(errorThreshold, nbInitialVectors, nbDIQueries, nbTestVectors, settleThreshold);
+		} else if (errorThreshold <= 0.0) {
 			attack.runSat(nbInitialVectors);
 		} else {
 			attack.runAppSat(errorThreshold, nbInitialVectors, nbDIQueries, nbTestVectors, settleThreshold);
@@ -130,6 +182,19 @@ struct LogicLockingSatAttackPass : public Pass {
 		log("        error threshold for approximate attacks, in percent (default=0.0)\n");
 		log("    -nb-initial-vectors <value>\n");
 		log("        number of initial random input patterns to match (default=16)\n");
+		log("    -telemetry <file>\n");
+		log("        write the metrics of each solver query (time, variables, clauses, test vectors,\n");
+		log("        approximate error) to this file, one JSON object per line\n");
+		log("    -checkpoint <file>\n");
+		log("        periodically save the attack state (test vectors, best key) to this file\n");
+		log("    -checkpoint-interval <seconds>\n");
+		log("        minimum time between two checkpoints (default=60)\n");
+		log("    -resume <file>\n");
+		log("        restart the attack from a checkpoint\n");
+		log("    -decompose\n");
+		log("        split the key into groups of bits that affect disjoint outputs, and attack\n");
+		log("        each group independently on its own output cone; the groups are attacked\n");
+		log("        sequentially and share the time limit\n");
 		log("\n");
 		log("The following options are used to execute the approximate attack when the error\n");
 		log("threshold is non-zero:\n");
@@ -140,6 +205,8 @@ struct LogicLockingSatAttackPass : public Pass {
 		log("    -settle-threshold <value>\n");
 		log("        number of tests before the key is considered good enough (default=2)\n");
 		log("\n");
+		log("    -trace <file>\n");
+		log("        record the time spent in each phase of the pass, in Chrome trace format\n");
 		log("\n");
 		log("\n");
 	}
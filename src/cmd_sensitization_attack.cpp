@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "command_utils.hpp"
+#include "phase_trace.hpp"
+#include "sensitization_attack.hpp"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct LogicLockingSensitizationAttackPass : public Pass {
+	LogicLockingSensitizationAttackPass() : Pass("ll_sensitization_attack") {}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing LOGIC_LOCKING_SENSITIZATION_ATTACK pass.\n");
+
+		int nbTestVectors = 16;
+		int nbMaskingKeys = 16;
+		int nbSatQueries = 8;
+		std::string portName = "moosic_key";
+		std::string key;
+		std::string traceFile;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-nb-test-vectors") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbTestVectors = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-nb-masking-keys") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbMaskingKeys = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-nb-sat-queries") {
+				if (argidx + 1 >= args.size())
+					break;
+				nbSatQueries = std::atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-key") {
+				if (argidx + 1 >= args.size())
+					break;
+				key = args[++argidx].c_str();
+				continue;
+			}
+			if (arg == "-port-name") {
+				if (argidx + 1 >= args.size())
+					break;
+				portName = args[++argidx];
+				continue;
+			}
+			if (arg == "-trace") {
+				if (argidx + 1 >= args.size())
+					break;
+				traceFile = args[++argidx];
+				continue;
+			}
+			break;
+		}
+
+		// handle extra options (e.g. selection)
+		extra_args(args, argidx, design);
+
+		std::vector<bool> key_values = parse_hex_string_to_bool(key);
+		RTLIL::Module *mod = single_selected_module(design);
+		if (mod == NULL)
+			return;
+
+		TraceSession traceSession("ll_sensitization_attack", traceFile);
+
+		if (nbTestVectors < 0 || nbMaskingKeys < 1 || nbSatQueries < 0) {
+			log_cmd_error("Invalid option value.\n");
+		}
+
+		SensitizationAttack attack(mod, portName, key_values);
+		attack.run(nbTestVectors, nbMaskingKeys, nbSatQueries);
+	}
+
+	void help() override
+	{
+		log("\n");
+		log("    ll_sensitization_attack  -key <correct_key> [options]\n");
+		log("\n");
+		log("This command performs a key sensitization attack against a locked design.\n");
+		log("For each key bit, it looks for an input pattern that propagates the key bit to an\n");
+		log("output while all other key bits are masked, then reads the key bit from the oracle.\n");
+		log("It is much cheaper than a Sat attack, and reveals weak locking before running one.\n");
+		log("As for the Sat attack, the oracle is simulated by running the circuit with the correct key.\n");
+		log("\n");
+		log("    -key <value>\n");
+		log("        correct key for the module\n");
+		log("    -port-name <value>\n");
+		log("        name for the key input (default=moosic_key)\n");
+		log("\n");
+		log("The following options control the attack algorithm:\n");
+		log("    -nb-test-vectors <value>\n");
+		log("        number of random test vectors (64 patterns each) to look for isolating patterns (default=16)\n");
+		log("    -nb-masking-keys <value>\n");
+		log("        number of random values of the other key bits tried on each pattern (default=16)\n");
+		log("    -nb-sat-queries <value>\n");
+		log("        maximum number of Sat-guided patterns for key bits not isolated by simulation (default=8)\n");
+		log("\n");
+		log("    -trace <file>\n");
+		log("        record the time spent in each phase of the pass, in Chrome trace format\n");
+		log("\n");
+		log("\n");
+	}
+} LogicLockingSensitizationAttackPass;
+
+PRIVATE_NAMESPACE_END
@@ -5,6 +5,7 @@
 #include "kernel/yosys.h"
 
 #include "command_utils.hpp"
+#include "phase_trace.hpp"
 
 #include <sstream>
 
@@ -41,6 +42,8 @@ struct LogicLockingShowPass : public Pass {
 		if (mod == NULL)
 			return;
 
+		TraceSession trace_session("ll_show");
+
 		std::vector<Cell *> locked_gates = showSol ? get_locked_cells(mod, solution) : get_lockable_cells(mod);
 		std::vector<SigBit> locked_signals = showSol ? get_locked_signals(mod, solution) : get_lockable_signals(mod);
 		log_assert(locked_gates.size() == locked_signals.size());
@@ -6,6 +6,7 @@
 
 #include "command_utils.hpp"
 #include "gate_insertion.hpp"
+#include "phase_trace.hpp"
 
 #include <limits>
 
@@ -48,6 +49,8 @@ struct LogicLockingUnlockkPass : public Pass {
 		if (mod == NULL)
 			return;
 
+		TraceSession trace_session("ll_unlock");
+
 		replace_port_by_constant(mod, port_name, key);
 	}
 
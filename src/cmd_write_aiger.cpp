@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "kernel/yosys.h"
+
+#include "analysis_context.hpp"
+#include "command_utils.hpp"
+#include "phase_trace.hpp"
+
+#include <fstream>
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+struct LogicLockingWriteAigerPass : public Pass {
+	LogicLockingWriteAigerPass() : Pass("ll_write_aiger") {}
+	void execute(std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		log_header(design, "Executing LOGIC_LOCKING_WRITE_AIGER pass.\n");
+
+		size_t argidx = 1;
+		std::string filename;
+		if (argidx < args.size() && args[argidx].compare(0, 1, "-") != 0) {
+			filename = args[argidx++];
+		}
+		if (filename.empty()) {
+			log_cmd_error("Missing output file name.\n");
+		}
+
+		// handle extra options (e.g. selection)
+		extra_args(args, argidx, design);
+
+		RTLIL::Module *mod = single_selected_module(design);
+		if (mod == NULL)
+			return;
+
+		TraceSession trace_session("ll_write_aiger");
+
+		std::ofstream f(filename, std::ios::binary);
+		if (!f) {
+			log_cmd_error("Could not open file %s for writing.\n", filename.c_str());
+		}
+		LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(mod);
+		pw.write_aiger(f);
+		log("Wrote the Aig of module %s to %s: %d inputs, %d outputs, %d and gates, %d lockable signals.\n", log_id(mod->name),
+		    filename.c_str(), pw.aig().nbInputs(), pw.aig().nbOutputs(), pw.aig().nbNodes(), GetSize(pw.get_lockable_signals()));
+	}
+
+	void help() override
+	{
+		log("\n");
+		log("    ll_write_aiger <filename>\n");
+		log("\n");
+		log("This command writes the Aig used by the logic locking analyses in binary Aiger format.\n");
+		log("Flip-flops are cut: their outputs are written as inputs and their inputs as outputs, as in\n");
+		log("the analyses. The symbol table gives the names of the inputs and outputs, and the lockable\n");
+		log("signals are listed with their literal as \"moosic-toggle <literal> <name>\" comment lines.\n");
+		log("\n");
+		log("\n");
+		log("\n");
+	}
+} LogicLockingWriteAigerPass;
+
+PRIVATE_NAMESPACE_END
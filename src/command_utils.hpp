@@ -7,6 +7,7 @@
 
 #include "kernel/rtlil.h"
 
+#include <cstdint>
 #include <string>
 
 /**
@@ -54,6 +55,21 @@ void report_locking(Yosys::RTLIL::Module *mod, const std::vector<Yosys::RTLIL::C
  */
 void report_security(Yosys::RTLIL::Module *mod, const std::string &port_name, std::vector<bool> key, int nb_analysis_keys, int nb_analysis_vectors);
 
+/**
+ * @brief Report the signal probability skew of the gates, to find the point-function blocks of a locked module
+ */
+void report_signal_skew(Yosys::RTLIL::Module *mod, const std::string &port_name, std::uint64_t nb_patterns, int nb_threads, int nb_reported);
+
+/**
+ * @brief Report the cost of the incremental simulation of each lockable signal, to find what limits the analysis
+ */
+void report_simulation_profile(Yosys::RTLIL::Module *mod, int nb_analysis_vectors, int nb_reported);
+
+/**
+ * @brief Report the corruption caused by each lockable signal on a few patterns, simulating 64 signals at once
+ */
+void report_screening(Yosys::RTLIL::Module *mod, int nb_patterns, int nb_reported);
+
 /**
  * @brief Export a boolean vector as an hexadecimal string
  */
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "cop_testability.hpp"
+
+#include "phase_trace.hpp"
+
+CopTestability::CopTestability(const MiniAIG &aig) : probability_(aig.nbVars(), 0.0), observability_(aig.nbVars(), 0.0)
+{
+	TraceScope trace("cop_testability");
+	trace.addCounter("nodes", aig.nbNodes());
+	int nbInputs = aig.nbInputs();
+	for (int i = 1; i <= nbInputs; ++i) {
+		probability_[i] = 0.5;
+	}
+	for (int i = 0; i < aig.nbNodes(); ++i) {
+		probability_[i + nbInputs + 1] = probability(aig.nodeA(i)) * probability(aig.nodeB(i));
+	}
+
+	// Probability that no path to an output propagates a change, accumulated over the fanouts
+	std::vector<double> notObserved(aig.nbVars(), 1.0);
+	for (int o = 0; o < aig.nbOutputs(); ++o) {
+		notObserved[aig.output(o).variable()] = 0.0;
+	}
+	for (int i = aig.nbNodes() - 1; i >= 0; --i) {
+		int v = i + nbInputs + 1;
+		double obs = 1.0 - notObserved[v];
+		observability_[v] = obs;
+		Lit a = aig.nodeA(i);
+		Lit b = aig.nodeB(i);
+		if (a.variable() == b.variable()) {
+			// Buffer, or constant zero if the polarities differ
+			if (a.polarity() == b.polarity()) {
+				notObserved[a.variable()] *= 1.0 - obs;
+			}
+			continue;
+		}
+		// A change on one input reaches the output when the other input is one
+		notObserved[a.variable()] *= 1.0 - obs * probability(b);
+		notObserved[b.variable()] *= 1.0 - obs * probability(a);
+	}
+	for (int v = 0; v <= nbInputs; ++v) {
+		observability_[v] = 1.0 - notObserved[v];
+	}
+}
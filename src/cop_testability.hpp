@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_COP_TESTABILITY_H
+#define MOOSIC_COP_TESTABILITY_H
+
+#include "mini_aig.hpp"
+
+#include <vector>
+
+/**
+ * @brief Analytic testability measures of an AIG (COP), without simulation
+ *
+ * The probability of each node being one is propagated from the inputs (probability 0.5), and the
+ * probability that toggling a node changes an output is propagated back from the outputs, assuming that
+ * all signals are independent. Both take a single linear pass, and give a fast estimate of the corruption
+ * caused by locking a node on designs too large for simulation-based analysis; reconvergent logic makes
+ * the estimates less accurate.
+ */
+class CopTestability
+{
+      public:
+	/**
+	 * @brief Compute the testability measures of the AIG
+	 */
+	explicit CopTestability(const MiniAIG &aig);
+
+	/**
+	 * @brief Probability of a literal being one
+	 */
+	double probability(Lit l) const { return l.polarity() ? 1.0 - probability_[l.variable()] : probability_[l.variable()]; }
+
+	/**
+	 * @brief Probability that toggling a literal changes at least one output
+	 */
+	double observability(Lit l) const { return observability_[l.variable()]; }
+
+      private:
+	std::vector<double> probability_;
+	std::vector<double> observability_;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "corruption_analysis.hpp"
+#include "phase_trace.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+std::vector<std::vector<std::uint64_t>> generateTestVectors(int nbInputs, int nbTestVectors, std::size_t seed)
+{
+	std::mt19937 rgen(seed);
+	std::uniform_int_distribution<std::uint64_t> dist;
+	std::vector<std::vector<std::uint64_t>> ret;
+	for (int i = 0; i < nbTestVectors; ++i) {
+		std::vector<std::uint64_t> tv;
+		for (int j = 0; j < nbInputs; ++j) {
+			tv.push_back(dist(rgen));
+		}
+		ret.push_back(tv);
+	}
+	return ret;
+}
+
+namespace
+{
+/**
+ * @brief Collect the transitive fanout of a variable, including itself; return false if it exceeds maxSize nodes
+ *
+ * @param visited Marks of the visited variables, set to mark for the variables of the cone
+ */
+bool collectFanoutCone(const MiniAIG &aig, std::uint32_t var, int maxSize, std::size_t mark, std::vector<std::size_t> &visited,
+		       std::vector<std::uint32_t> &cone)
+{
+	cone.clear();
+	cone.push_back(var);
+	visited[var] = mark;
+	for (std::size_t i = 0; i < cone.size(); ++i) {
+		for (std::uint32_t n : aig.fanouts(cone[i])) {
+			if (visited[n] == mark) {
+				continue;
+			}
+			if ((int)cone.size() >= maxSize) {
+				return false;
+			}
+			visited[n] = mark;
+			cone.push_back(n);
+		}
+	}
+	return true;
+}
+} // namespace
+
+std::vector<ToggleGroup> groupDisjointToggles(const MiniAIG &aig, const std::vector<Lit> &toggles, int maxConeSize)
+{
+	std::vector<ToggleGroup> groups;
+	std::vector<std::vector<std::uint32_t>> cones(toggles.size());
+	std::vector<std::size_t> pending;
+	std::vector<std::size_t> visited(aig.nbVars(), 0);
+	std::vector<std::uint32_t> cone;
+	auto addAlone = [&](std::size_t j) {
+		ToggleGroup group;
+		group.toggles.push_back(j);
+		for (int k = 0; k < aig.nbOutputs(); ++k) {
+			group.outputOwners.emplace_back(k, j);
+		}
+		groups.push_back(group);
+	};
+	for (std::size_t j = 0; j < toggles.size(); ++j) {
+		if (collectFanoutCone(aig, toggles[j].variable(), maxConeSize, j + 1, visited, cone)) {
+			cones[j].swap(cone);
+			pending.push_back(j);
+		} else {
+			addAlone(j);
+		}
+	}
+
+	// Outputs sorted by variable, to find the outputs in a cone
+	std::vector<std::pair<std::uint32_t, int>> outputVars;
+	std::vector<char> isOutputVar(aig.nbVars(), false);
+	for (int k = 0; k < aig.nbOutputs(); ++k) {
+		outputVars.emplace_back(aig.output(k).variable(), k);
+		isOutputVar[aig.output(k).variable()] = true;
+	}
+	std::sort(outputVars.begin(), outputVars.end());
+
+	// First-fit packing, on a window of 64 groups at a time with a bitmask of the groups using each variable.
+	// Toggles that do not fit in the window are packed in the next one. They are taken in topological order,
+	// so that consecutive toggles of a group work on nearby nodes
+	auto topologicalOrder = [&](std::size_t a, std::size_t b) { return toggles[a].variable() < toggles[b].variable(); };
+	std::stable_sort(pending.begin(), pending.end(), topologicalOrder);
+	constexpr int windowSize = 64;
+	std::vector<std::uint64_t> usedGroups(aig.nbVars());
+	bool packed = true;
+	while (!pending.empty()) {
+		if (!packed) {
+			// The previous window did not pack anything: the remaining toggles conflict and are simulated alone
+			for (std::size_t j : pending) {
+				addAlone(j);
+			}
+			break;
+		}
+		std::fill(usedGroups.begin(), usedGroups.end(), 0);
+		std::vector<ToggleGroup> window(windowSize);
+		std::vector<std::size_t> deferred;
+		for (std::size_t j : pending) {
+			std::uint64_t used = 0;
+			for (std::uint32_t v : cones[j]) {
+				used |= usedGroups[v];
+			}
+			if (used == (std::uint64_t)-1) {
+				deferred.push_back(j);
+				continue;
+			}
+			int g = 0;
+			while ((used >> g) & 1) {
+				++g;
+			}
+			for (std::uint32_t v : cones[j]) {
+				usedGroups[v] |= (std::uint64_t)1 << g;
+				if (isOutputVar[v]) {
+					auto range = std::equal_range(outputVars.begin(), outputVars.end(), std::make_pair(v, 0),
+								      [](const auto &a, const auto &b) { return a.first < b.first; });
+					for (auto it = range.first; it != range.second; ++it) {
+						window[g].outputOwners.emplace_back(it->second, j);
+					}
+				}
+			}
+			window[g].toggles.push_back(j);
+		}
+		packed = false;
+		for (ToggleGroup &group : window) {
+			packed |= group.toggles.size() > 1;
+			if (!group.toggles.empty()) {
+				groups.push_back(std::move(group));
+			}
+		}
+		pending.swap(deferred);
+	}
+	// Simulate the groups in topological order too, so that consecutive propagations touch nearby nodes
+	std::stable_sort(groups.begin(), groups.end(),
+			 [&](const ToggleGroup &a, const ToggleGroup &b) { return topologicalOrder(a.toggles.front(), b.toggles.front()); });
+	return groups;
+}
+
+std::vector<std::vector<std::vector<std::uint64_t>>> computeOutputCorruption(const MiniAIG &aig, const std::vector<std::vector<std::uint64_t>> &testVectors,
+									    const std::vector<Lit> &toggles)
+{
+	TraceScope trace("output_corruption");
+	trace.addCounter("nodes", aig.nbNodes());
+	trace.addCounter("signals", toggles.size());
+	trace.addCounter("test_vectors", testVectors.size());
+	std::vector<ToggleGroup> groups = groupDisjointToggles(aig, toggles);
+	trace.addCounter("propagations", groups.size());
+	std::vector<std::vector<Lit>> groupLits;
+	for (const ToggleGroup &group : groups) {
+		std::vector<Lit> lits;
+		for (std::size_t j : group.toggles) {
+			lits.push_back(toggles[j]);
+		}
+		groupLits.push_back(lits);
+	}
+
+	// Outputs outside of the cone of a toggle are never corrupted by it
+	std::vector<std::vector<std::vector<std::uint64_t>>> corr(
+	  toggles.size(), std::vector<std::vector<std::uint64_t>>(aig.nbOutputs(), std::vector<std::uint64_t>(testVectors.size(), 0)));
+	SimContext sim(aig);
+	for (std::size_t i = 0; i < testVectors.size(); ++i) {
+		auto noToggle = sim.simulate(testVectors[i]);
+		sim.copyIncrementalState();
+		for (std::size_t g = 0; g < groups.size(); ++g) {
+			auto toggle = sim.simulateIncremental(groupLits[g]);
+			for (const auto &p : groups[g].outputOwners) {
+				corr[p.second][p.first][i] = toggle[p.first] ^ noToggle[p.first];
+			}
+		}
+	}
+	return corr;
+}
+
+std::vector<std::vector<std::vector<std::uint64_t>>> computeOutputCorruptionLaneSliced(const MiniAIG &aig,
+										      const std::vector<std::vector<std::uint64_t>> &testVectors,
+										      const std::vector<Lit> &toggles, int nbPatterns)
+{
+	TraceScope trace("output_corruption_lane_sliced");
+	trace.addCounter("nodes", aig.nbNodes());
+	trace.addCounter("signals", toggles.size());
+	trace.addCounter("patterns", nbPatterns);
+	if (nbPatterns < 0 || (std::size_t)nbPatterns > 64 * testVectors.size()) {
+		throw std::runtime_error("Not enough test vectors for the number of patterns");
+	}
+	std::size_t nbWords = (nbPatterns + 63) / 64;
+	std::vector<std::vector<std::vector<std::uint64_t>>> corr(
+	  toggles.size(), std::vector<std::vector<std::uint64_t>>(aig.nbOutputs(), std::vector<std::uint64_t>(nbWords, 0)));
+	SimContext sim(aig);
+	std::vector<std::uint64_t> inputs(aig.nbInputs());
+	std::vector<Lit> lanes;
+	for (int p = 0; p < nbPatterns; ++p) {
+		const std::vector<std::uint64_t> &tv = testVectors[p / 64];
+		for (int i = 0; i < aig.nbInputs(); ++i) {
+			inputs[i] = ((tv[i] >> (p % 64)) & 1) ? (std::uint64_t)-1 : 0;
+		}
+		auto noToggle = sim.simulate(inputs);
+		for (std::size_t start = 0; start < toggles.size(); start += 64) {
+			std::size_t end = std::min(toggles.size(), start + 64);
+			lanes.assign(toggles.begin() + start, toggles.begin() + end);
+			auto toggle = sim.simulateWithLaneToggling(inputs, lanes);
+			for (std::size_t k = 0; k < toggle.size(); ++k) {
+				std::uint64_t diff = toggle[k] ^ noToggle[k];
+				for (std::size_t lane = 0; diff != 0; ++lane, diff >>= 1) {
+					if (diff & 1) {
+						corr[start + lane][k][p / 64] |= (std::uint64_t)1 << (p % 64);
+					}
+				}
+			}
+		}
+	}
+	return corr;
+}
+
+std::vector<ToggleProfile> profileIncrementalSimulation(const MiniAIG &aig, const std::vector<std::vector<std::uint64_t>> &testVectors,
+							const std::vector<Lit> &toggles)
+{
+	TraceScope trace("profile_simulation");
+	std::vector<ToggleProfile> ret(toggles.size());
+	for (std::size_t j = 0; j < toggles.size(); ++j) {
+		ret[j].coneSize = aig.fanoutConeSize(toggles[j]);
+	}
+	SimContext sim(aig);
+	for (const std::vector<std::uint64_t> &tv : testVectors) {
+		auto noToggle = sim.simulate(tv);
+		sim.copyIncrementalState();
+		for (std::size_t j = 0; j < toggles.size(); ++j) {
+			sim.resetSimStats();
+			auto toggle = sim.simulateIncremental(toggles[j]);
+			if (toggle == noToggle) {
+				++ret[j].nbMasked;
+			}
+			const IncrementalSimStats &stats = sim.simStats();
+			ret[j].stats.nbToggles += stats.nbToggles;
+			ret[j].stats.nbEvaluated += stats.nbEvaluated;
+			ret[j].stats.nbChanged += stats.nbChanged;
+			ret[j].stats.nbHeapOps += stats.nbHeapOps;
+			ret[j].stats.bytesTouched += stats.bytesTouched;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_CORRUPTION_ANALYSIS_H
+#define MOOSIC_CORRUPTION_ANALYSIS_H
+
+#include "mini_aig.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Generate random test vectors (64 patterns each) for an Aig with this number of inputs
+ */
+std::vector<std::vector<std::uint64_t>> generateTestVectors(int nbInputs, int nbTestVectors, std::size_t seed);
+
+/**
+ * @brief Maximum fanout cone size of a toggle batched with others; larger toggles are simulated alone
+ */
+constexpr int defaultMaxBatchedConeSize = 256;
+
+/**
+ * @brief Toggles with pairwise-disjoint fanout cones, simulated in a single incremental pass
+ */
+struct ToggleGroup {
+	/// Indices of the toggles in the group
+	std::vector<std::size_t> toggles;
+	/// Outputs in the fanout cone of a toggle of the group, with the index of this toggle
+	std::vector<std::pair<int, std::size_t>> outputOwners;
+};
+
+/**
+ * @brief Pack toggles with pairwise-disjoint fanout cones into groups
+ *
+ * Toggling all literals of a group at once gives the same outputs as toggling them one by one, and
+ * each output that changes is attributed to the only toggle whose cone contains it.
+ * Toggles with more than maxConeSize nodes in their cone are alone in their group.
+ * Groups are returned in topological order of their first toggle, to keep the simulation local.
+ */
+std::vector<ToggleGroup> groupDisjointToggles(const MiniAIG &aig, const std::vector<Lit> &toggles, int maxConeSize = defaultMaxBatchedConeSize);
+
+/**
+ * @brief Compute the impact of toggling each of these literals in turn (per toggle per output per test vector)
+ *
+ * A bit is set when toggling the literal changes the output for this pattern.
+ * Toggles with disjoint fanout cones are simulated together, in a single incremental pass, and in topological
+ * order rather than in the order given; the results are in the order given.
+ */
+std::vector<std::vector<std::vector<std::uint64_t>>> computeOutputCorruption(const MiniAIG &aig, const std::vector<std::vector<std::uint64_t>> &testVectors,
+									    const std::vector<Lit> &toggles);
+
+/**
+ * @brief Compute the impact of toggling each literal on the first patterns of the test vectors, with one toggle per lane
+ *
+ * Each pattern is broadcast to all 64 lanes, and 64 toggles are simulated at once with each toggle in its own lane:
+ * this takes one full simulation per pattern and per 64 toggles, which is faster than computeOutputCorruption for quick
+ * screening on a few patterns. The result has the same layout as computeOutputCorruption, with one word per
+ * 64 patterns (per toggle per output per word).
+ */
+std::vector<std::vector<std::vector<std::uint64_t>>> computeOutputCorruptionLaneSliced(const MiniAIG &aig,
+										      const std::vector<std::vector<std::uint64_t>> &testVectors,
+										      const std::vector<Lit> &toggles, int nbPatterns);
+
+/**
+ * @brief Cost of the incremental simulation of a toggle
+ */
+struct ToggleProfile {
+	/// Number of nodes in the transitive fanout of the toggled literal
+	int coneSize = 0;
+	/// Number of test vectors for which no output changed
+	int nbMasked = 0;
+	/// Simulation counters, only available when compiled with MOOSIC_SIM_STATS
+	IncrementalSimStats stats;
+};
+
+/**
+ * @brief Run the incremental simulation of each toggle as in computeOutputCorruption, and measure its cost
+ */
+std::vector<ToggleProfile> profileIncrementalSimulation(const MiniAIG &aig, const std::vector<std::vector<std::uint64_t>> &testVectors,
+							const std::vector<Lit> &toggles);
+
+#endif
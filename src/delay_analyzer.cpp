@@ -4,9 +4,13 @@
 
 #include "delay_analyzer.hpp"
 
-#include "logic_locking_analyzer.hpp"
+#include "kernel/celltypes.h"
+#include "kernel/sigtools.h"
+#include "kernel/yosys.h"
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 
 USING_YOSYS_NAMESPACE
 
@@ -14,86 +18,275 @@ constexpr int DelayAnalyzer::CELL_DELAY;
 
 DelayAnalyzer::DelayAnalyzer(Module *module, const std::vector<Cell *> &cells)
 
-    : module_(module)
+    : module_(module), nbLockable_(GetSize(cells))
 {
 	initGraph(cells);
+	initTiming();
 }
 
 void DelayAnalyzer::initGraph(const std::vector<Cell *> &cells)
 {
-	nodeOrder_.clear();
-	dependencies_.clear();
-
-	// Get the dependency graph
-	LogicLockingAnalyzer pw(module_);
-	auto deps = pw.compute_dependency_graph();
-
-	// Now analyze this graph to get a topological sort
+	// Number the nodes: insertion positions first, then the other cells as they appear in the graph
 	dict<Cell *, int> cellToNode;
 	for (int i = 0; i < GetSize(cells); ++i) {
 		assert(!cellToNode.count(cells[i]));
 		cellToNode[cells[i]] = i;
 	}
-	int nodeInd = GetSize(cells);
-	for (auto p : deps) {
-		if (!cellToNode.count(p.first)) {
-			cellToNode[p.first] = nodeInd++;
+	int nbNodes = GetSize(cells);
+	auto getNode = [&](Cell *c) -> int {
+		auto it = cellToNode.find(c);
+		if (it != cellToNode.end()) {
+			return it->second;
 		}
-		if (!cellToNode.count(p.second)) {
-			cellToNode[p.second] = nodeInd++;
+		cellToNode[c] = nbNodes;
+		return nbNodes++;
+	};
+
+	// Drivers of each net; only combinatorial cells propagate timing
+	SigMap sigmap(module_);
+	dict<SigBit, Cell *> netDriver;
+	for (Cell *c : module_->cells()) {
+		if (!yosys_celltypes.cell_evaluable(c->type)) {
+			continue;
+		}
+		for (auto conn : c->connections()) {
+			if (!c->output(conn.first)) {
+				continue;
+			}
+			for (SigBit b : sigmap(conn.second)) {
+				if (b.wire) {
+					netDriver[b] = c;
+				}
+			}
 		}
 	}
-	dependencies_.resize(nodeInd);
-	for (auto p : deps) {
-		int from = cellToNode.at(p.first);
-		int to = cellToNode.at(p.second);
-		assert(from != to);
-		dependencies_[to].push_back(TimingDependency{.from = from, .delay = 0});
+
+	// Dependencies from the driver of each net to the cells connected to it
+	std::vector<std::pair<int, int>> edges;
+	for (Cell *c : module_->cells()) {
+		for (auto conn : c->connections()) {
+			for (SigBit b : sigmap(conn.second)) {
+				auto it = netDriver.find(b);
+				if (it == netDriver.end() || it->second == c) {
+					continue;
+				}
+				int from = getNode(it->second);
+				edges.emplace_back(from, getNode(c));
+			}
+		}
 	}
 
-	// Now perform the topo sort
-	std::vector<int> count(nodeInd, 0);
-	for (int i = 0; i < nodeInd; ++i) {
-		for (TimingDependency dep : dependencies_[i]) {
-			++count[dep.from];
+	// Fill the compressed sparse row arrays
+	faninStart_.assign(nbNodes + 1, 0);
+	fanoutStart_.assign(nbNodes + 1, 0);
+	for (auto e : edges) {
+		++faninStart_[e.second + 1];
+		++fanoutStart_[e.first + 1];
+	}
+	for (int i = 0; i < nbNodes; ++i) {
+		faninStart_[i + 1] += faninStart_[i];
+		fanoutStart_[i + 1] += fanoutStart_[i];
+	}
+	fanins_.resize(edges.size());
+	fanouts_.resize(edges.size());
+	std::vector<int> faninPos(faninStart_.begin(), faninStart_.end() - 1);
+	std::vector<int> fanoutPos(fanoutStart_.begin(), fanoutStart_.end() - 1);
+	for (auto e : edges) {
+		fanins_[faninPos[e.second]++] = e.first;
+		fanouts_[fanoutPos[e.first]++] = e.second;
+	}
+	nodeToOrder_.assign(nbNodes, 0);
+	initOrder();
+}
+
+void DelayAnalyzer::initOrder()
+{
+	// Topological sort by removing the nodes with no remaining fanin
+	int nbNodes = GetSize(nodeToOrder_);
+	std::vector<int> count(nbNodes);
+	nodeOrder_.clear();
+	for (int i = 0; i < nbNodes; ++i) {
+		count[i] = faninStart_[i + 1] - faninStart_[i];
+		if (count[i] == 0) {
+			nodeOrder_.push_back(i);
+		}
+	}
+	for (int i = 0; i < GetSize(nodeOrder_); ++i) {
+		int node = nodeOrder_[i];
+		for (int j = fanoutStart_[node]; j < fanoutStart_[node + 1]; ++j) {
+			if (--count[fanouts_[j]] == 0) {
+				nodeOrder_.push_back(fanouts_[j]);
+			}
 		}
 	}
+	if (GetSize(nodeOrder_) != nbNodes) {
+		log_error("Combinatorial loop detected in the timing graph.\n");
+	}
+
+	// Check the topo sort
+	for (int i = 0; i < nbNodes; ++i) {
+		nodeToOrder_[nodeOrder_[i]] = i;
+	}
+	for (int i = 0; i < nbNodes; ++i) {
+		for ([[maybe_unused]] int j = faninStart_[i]; j < faninStart_[i + 1]; ++j) {
+			assert(nodeToOrder_[fanins_[j]] < nodeToOrder_[i]);
+		}
+	}
+}
+
+void DelayAnalyzer::initTiming()
+{
+	currentSolution_.clear();
+	lockCount_.assign(nbNodes(), 0);
+	arrival_.assign(nbNodes(), 0);
+	arrivalCount_.assign(1, nbNodes());
+	maxArrival_ = 0;
+	isQueued_.assign(nbNodes(), false);
+	for (int n : nodeOrder_) {
+		setArrival(n, computeArrival(n));
+	}
+	departure_.assign(nbNodes(), 0);
+	isQueuedBackward_.assign(nbNodes(), false);
+	for (auto it = nodeOrder_.rbegin(); it != nodeOrder_.rend(); ++it) {
+		departure_[*it] = computeDeparture(*it);
+	}
+}
+
+int DelayAnalyzer::computeArrival(int node) const
+{
+	int delay = 0;
+	for (int j = faninStart_[node]; j < faninStart_[node + 1]; ++j) {
+		delay = std::max(delay, arrival_[fanins_[j]]);
+	}
+	return delay + CELL_DELAY * (1 + lockCount_[node]);
+}
 
-	std::vector<char> done(nodeInd, false);
-	std::vector<int> toVisit;
-	for (int i = 0; i < nodeInd; ++i) {
-		toVisit.push_back(i);
+int DelayAnalyzer::computeDeparture(int node) const
+{
+	int delay = 0;
+	for (int j = fanoutStart_[node]; j < fanoutStart_[node + 1]; ++j) {
+		int n = fanouts_[j];
+		delay = std::max(delay, departure_[n] + CELL_DELAY * (1 + lockCount_[n]));
 	}
+	return delay;
+}
+
+void DelayAnalyzer::setArrival(int node, int arrival)
+{
+	--arrivalCount_[arrival_[node]];
+	if (arrival >= GetSize(arrivalCount_)) {
+		arrivalCount_.resize(arrival + 1, 0);
+	}
+	++arrivalCount_[arrival];
+	arrival_[node] = arrival;
+	if (arrival > maxArrival_) {
+		maxArrival_ = arrival;
+	}
+	while (maxArrival_ > 0 && arrivalCount_[maxArrival_] == 0) {
+		--maxArrival_;
+	}
+}
 
-	while (!toVisit.empty()) {
-		int node = toVisit.back();
-		toVisit.pop_back();
-		if (done[node]) {
+void DelayAnalyzer::updateLocking(int node, int increment)
+{
+	assert(node >= 0 && node < nbNodes());
+	lockCount_[node] += increment;
+	assert(lockCount_[node] >= 0);
+	if (!isQueued_[node]) {
+		isQueued_[node] = true;
+		toVisit_.push(nodeToOrder_[node]);
+	}
+	// The delay of the node changed, so the departure times of its fanins must be updated
+	for (int j = faninStart_[node]; j < faninStart_[node + 1]; ++j) {
+		int n = fanins_[j];
+		if (!isQueuedBackward_[n]) {
+			isQueuedBackward_[n] = true;
+			toVisitBackward_.push(nodeToOrder_[n]);
+		}
+	}
+}
+
+void DelayAnalyzer::propagate()
+{
+	while (!toVisit_.empty()) {
+		int node = nodeOrder_[toVisit_.top()];
+		toVisit_.pop();
+		isQueued_[node] = false;
+		int arrival = computeArrival(node);
+		if (arrival == arrival_[node]) {
 			continue;
 		}
-		if (count[node] != 0) {
+		setArrival(node, arrival);
+		for (int j = fanoutStart_[node]; j < fanoutStart_[node + 1]; ++j) {
+			int n = fanouts_[j];
+			if (!isQueued_[n]) {
+				isQueued_[n] = true;
+				toVisit_.push(nodeToOrder_[n]);
+			}
+		}
+	}
+	while (!toVisitBackward_.empty()) {
+		int node = nodeOrder_[toVisitBackward_.top()];
+		toVisitBackward_.pop();
+		isQueuedBackward_[node] = false;
+		int departure = computeDeparture(node);
+		if (departure == departure_[node]) {
 			continue;
 		}
-		done[node] = true;
-		nodeOrder_.push_back(node);
-		for (TimingDependency dep : dependencies_[node]) {
-			--count[dep.from];
-			toVisit.push_back(dep.from);
+		departure_[node] = departure;
+		for (int j = faninStart_[node]; j < faninStart_[node + 1]; ++j) {
+			int n = fanins_[j];
+			if (!isQueuedBackward_[n]) {
+				isQueuedBackward_[n] = true;
+				toVisitBackward_.push(nodeToOrder_[n]);
+			}
 		}
 	}
-	std::reverse(nodeOrder_.begin(), nodeOrder_.end());
-	assert(GetSize(nodeOrder_) == nodeInd);
+}
 
-	// Check the topo sort
-	std::vector<int> nodeToOrder(nodeOrder_.size());
-	for (int i = 0; i < nodeInd; ++i) {
-		nodeToOrder[nodeOrder_[i]] = i;
+void DelayAnalyzer::addLocking(int node)
+{
+	currentSolution_.insert(std::upper_bound(currentSolution_.begin(), currentSolution_.end(), node), node);
+	updateLocking(node, 1);
+	propagate();
+}
+
+void DelayAnalyzer::removeLocking(int node)
+{
+	auto it = std::lower_bound(currentSolution_.begin(), currentSolution_.end(), node);
+	if (it == currentSolution_.end() || *it != node) {
+		throw std::runtime_error("Removing a locking gate that is not in the solution");
 	}
-	for (int i = 0; i < nodeInd; ++i) {
-		for ([[maybe_unused]] TimingDependency dep : dependencies_[i]) {
-			assert(nodeToOrder[dep.from] < nodeToOrder[i]);
-		}
+	currentSolution_.erase(it);
+	updateLocking(node, -1);
+	propagate();
+}
+
+int DelayAnalyzer::incrementalDelay(const Solution &sol)
+{
+	Solution target = sol;
+	std::sort(target.begin(), target.end());
+	Solution added, removed;
+	std::set_difference(target.begin(), target.end(), currentSolution_.begin(), currentSolution_.end(), std::back_inserter(added));
+	std::set_difference(currentSolution_.begin(), currentSolution_.end(), target.begin(), target.end(), std::back_inserter(removed));
+	for (int n : added) {
+		updateLocking(n, 1);
+	}
+	for (int n : removed) {
+		updateLocking(n, -1);
+	}
+	currentSolution_ = target;
+	propagate();
+	return currentDelay();
+}
+
+std::vector<char> DelayAnalyzer::delayNeutralMask() const
+{
+	std::vector<char> ret(nbLockable_);
+	for (int i = 0; i < nbLockable_; ++i) {
+		ret[i] = !changesDelay(i);
 	}
+	return ret;
 }
 
 int DelayAnalyzer::delay(const Solution &sol) const
@@ -105,8 +298,8 @@ int DelayAnalyzer::delay(const Solution &sol) const
 	}
 	for (int n : nodeOrder_) {
 		int delay = 0;
-		for (TimingDependency dep : dependencies_[n]) {
-			delay = std::max(delay, delays[dep.from] + dep.delay);
+		for (int j = faninStart_[n]; j < faninStart_[n + 1]; ++j) {
+			delay = std::max(delay, delays[fanins_[j]]);
 		}
 		delay += additionalDelay[n];
 		delays[n] = delay;
@@ -7,6 +7,9 @@
 
 #include "kernel/rtlil.h"
 
+#include <algorithm>
+#include <queue>
+
 using Yosys::RTLIL::Cell;
 using Yosys::RTLIL::Module;
 
@@ -29,13 +32,54 @@ class DelayAnalyzer
 	/**
 	 * @brief Return the total number of insertion positions
 	 */
-	int nbNodes() const { return dependencies_.size(); }
+	int nbNodes() const { return nodeToOrder_.size(); }
 
 	/**
 	 * @brief Compute the delay associated with a locking solution
 	 */
 	int delay(const Solution &sol) const;
 
+	/**
+	 * @brief Compute the delay associated with a locking solution, updating the arrival times incrementally from the
+	 * previous solution
+	 */
+	int incrementalDelay(const Solution &sol);
+
+	/**
+	 * @brief Add a locking gate to a node of the current solution and update the arrival times
+	 */
+	void addLocking(int node);
+
+	/**
+	 * @brief Remove a locking gate from a node of the current solution and update the arrival times
+	 */
+	void removeLocking(int node);
+
+	/**
+	 * @brief Return the delay of the current solution
+	 */
+	int currentDelay() const { return maxArrival_; }
+
+	/**
+	 * @brief Return the slack of a node for the current solution
+	 */
+	int slack(int node) const { return maxArrival_ - departure_[node] - arrival_[node]; }
+
+	/**
+	 * @brief Return whether inserting a locking gate on this node would increase the delay of the current solution
+	 */
+	bool changesDelay(int node) const { return slack(node) < CELL_DELAY; }
+
+	/**
+	 * @brief Return the delay obtained by inserting a locking gate on this node in the current solution
+	 */
+	int delayWithLocking(int node) const { return std::max(maxArrival_, arrival_[node] + CELL_DELAY + departure_[node]); }
+
+	/**
+	 * @brief Return for each insertion position whether a locking gate can be inserted without increasing the delay
+	 */
+	std::vector<char> delayNeutralMask() const;
+
 	/**
 	 * @brief Check the datastructure
 	 */
@@ -43,25 +87,99 @@ class DelayAnalyzer
 
       private:
 	/**
-	 * @brief Representation of a timing dependency
+	 * @brief Build the timing graph directly from the module connectivity
 	 */
-	struct TimingDependency {
-		int from;
-		int delay;
-	};
 	void initGraph(const std::vector<Cell *> &cells);
 
+	/**
+	 * @brief Compute the topological sort of the timing graph
+	 */
+	void initOrder();
+
+	/**
+	 * @brief Compute the arrival times with no locking
+	 */
+	void initTiming();
+
+	/**
+	 * @brief Arrival time of a node from the arrival times of its dependencies
+	 */
+	int computeArrival(int node) const;
+
+	/**
+	 * @brief Departure time of a node from the departure times of the nodes that depend on it
+	 */
+	int computeDeparture(int node) const;
+
+	/**
+	 * @brief Change the number of locking gates on a node and schedule it for update
+	 */
+	void updateLocking(int node, int increment);
+
+	/**
+	 * @brief Update the arrival times of the scheduled nodes and their forward cone, then the departure times of
+	 * their backward cone, until they stop changing
+	 */
+	void propagate();
+
+	/**
+	 * @brief Update the arrival time of a node and the per-delay node count
+	 */
+	void setArrival(int node, int arrival);
+
       private:
 	static constexpr int CELL_DELAY = 1;
 
 	// Module
 	Module *module_;
 
+	// Number of insertion positions, numbered first among the nodes
+	int nbLockable_;
+
 	// Topological sort for timing computation
 	std::vector<int> nodeOrder_;
 
-	// Timing dependencies between nodes
-	std::vector<std::vector<TimingDependency>> dependencies_;
+	// Timing dependencies between nodes, in compressed sparse row format: the fanins of node i are
+	// fanins_[faninStart_[i]] to fanins_[faninStart_[i+1]-1]
+	std::vector<int> faninStart_;
+	std::vector<int> fanins_;
+
+	// Nodes that depend on each node, in compressed sparse row format
+	std::vector<int> fanoutStart_;
+	std::vector<int> fanouts_;
+
+	// Position of each node in the topological sort
+	std::vector<int> nodeToOrder_;
+
+	// Current solution for incremental timing, sorted
+	Solution currentSolution_;
+
+	// Number of locking gates on each node for the current solution
+	std::vector<int> lockCount_;
+
+	// Arrival time of each node for the current solution
+	std::vector<int> arrival_;
+
+	// Number of nodes for each arrival time, to maintain the critical delay
+	std::vector<int> arrivalCount_;
+
+	// Maximum arrival time for the current solution
+	int maxArrival_;
+
+	// Longest delay from the output of each node to the end of the timing graph, for the current solution
+	std::vector<int> departure_;
+
+	// Whether a node is scheduled for update
+	std::vector<char> isQueued_;
+
+	// Nodes to update, by position in the topological sort
+	std::priority_queue<int, std::vector<int>, std::greater<int>> toVisit_;
+
+	// Whether a node is scheduled for departure time update
+	std::vector<char> isQueuedBackward_;
+
+	// Nodes to update, by reverse position in the topological sort
+	std::priority_queue<int> toVisitBackward_;
 };
 
 #endif
\ No newline at end of file
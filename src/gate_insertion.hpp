@@ -17,7 +17,17 @@ using Yosys::RTLIL::SigBit;
 using Yosys::RTLIL::SigSpec;
 using Yosys::RTLIL::Wire;
 
-enum class OptimizationTarget { PairwiseSecurity, PairwiseSecurityNoDedup, OutputCorruption, Hybrid, FaultAnalysisFll, FaultAnalysisKip, Outputs };
+enum class OptimizationTarget {
+	PairwiseSecurity,
+	PairwiseSecurityNoDedup,
+	OutputCorruption,
+	TimingCorruption,
+	Hybrid,
+	FaultAnalysisFll,
+	FaultAnalysisKip,
+	AnalyticCorruption,
+	Outputs
+};
 enum class SatCountermeasure { None, AntiSat, SarLock, CasLock, SkgLock, SkgLockPlus };
 
 /**
@@ -3,11 +3,17 @@
  */
 
 #include "logic_locking_analyzer.hpp"
+#include "aig_sweeping.hpp"
+#include "aiger.hpp"
+#include "analysis_cache.hpp"
+#include "cop_testability.hpp"
+#include "corruption_analysis.hpp"
+#include "phase_trace.hpp"
 
 #include "kernel/celltypes.h"
 
+#include <algorithm>
 #include <bitset>
-#include <random>
 
 #ifdef DEBUG_LOGIC_SIMULATION
 constexpr bool check_sim = true;
@@ -21,9 +27,55 @@ LogicLockingAnalyzer::LogicLockingAnalyzer(RTLIL::Module *module) : module_(modu
 {
 	comb_inputs_ = get_comb_inputs();
 	comb_outputs_ = get_comb_outputs();
-	init_wire_to_cells();
-	init_wire_to_wires();
+	init_signal_ids();
 	init_aig();
+	sweep_aig();
+	reset_test_vector_data();
+}
+
+LogicLockingAnalyzer::LogicLockingAnalyzer(RTLIL::Module *module, std::uint64_t hash) : module_(module)
+{
+	comb_inputs_ = get_comb_inputs();
+	comb_outputs_ = get_comb_outputs();
+	init_signal_ids();
+	std::string path = AnalysisCache::artifact_path(hash, "aig");
+	if (load_aig(path, hash)) {
+		log("Loaded the Aig of module %s from %s.\n", log_id(module->name), path.c_str());
+	} else {
+		init_aig();
+		sweep_aig();
+		AnalysisCache::save_aig(path, hash, *aig_, id_to_aig_, id_in_aig_);
+	}
+	reset_test_vector_data();
+}
+
+bool LogicLockingAnalyzer::load_aig(const std::string &path, std::uint64_t hash)
+{
+	aig_ = std::make_shared<MiniAIG>();
+	if (!AnalysisCache::load_aig(path, hash, *aig_, id_to_aig_, id_in_aig_)) {
+		return false;
+	}
+	if (GetSize(id_to_aig_) != nb_signals_ || aig_->nbInputs() != nb_inputs() || aig_->nbOutputs() != nb_outputs()) {
+		return false;
+	}
+	// Recover the driver of each signal as done by the conversion: the first cell in order to drive a signal that is not an input
+	cell_order_ = compute_conversion_order();
+	id_to_driver_.assign(nb_signals_, nullptr);
+	std::vector<char> driven(nb_signals_, false);
+	for (SigBit bit : comb_inputs_) {
+		driven[get_signal_id(bit)] = true;
+	}
+	for (Cell *c : cell_order_) {
+		if (!yosys_celltypes.cell_evaluable(c->type) || !c->hasPort(ID::Y) || GetSize(c->getPort(ID::Y)) != 1) {
+			continue;
+		}
+		int id = get_signal_id(c->getPort(ID::Y));
+		if (id > State::Sm && !driven[id]) {
+			driven[id] = true;
+			id_to_driver_[id] = c;
+		}
+	}
+	return true;
 }
 
 pool<SigBit> LogicLockingAnalyzer::get_comb_inputs(RTLIL::Module *mod)
@@ -118,16 +170,20 @@ std::vector<Cell *> LogicLockingAnalyzer::get_lockable_cells(Module *mod)
 
 void LogicLockingAnalyzer::gen_test_vectors(int nb, size_t seed)
 {
-	std::mt19937 rgen(seed);
-	std::uniform_int_distribution<std::uint64_t> dist;
-	test_vectors_.clear();
-	for (int i = 0; i < nb; ++i) {
-		std::vector<std::uint64_t> tv;
-		for (int j = 0; j < nb_inputs(); ++j) {
-			tv.push_back(dist(rgen));
-		}
-		test_vectors_.push_back(tv);
-	}
+	test_vectors_ = generateTestVectors(nb_inputs(), nb, seed);
+	reset_test_vector_data();
+}
+
+void LogicLockingAnalyzer::reset_test_vector_data()
+{
+	// Do not clear the data in place: it may be shared with copies that still use the previous test vectors
+	test_vector_data_ = std::make_shared<TestVectorData>();
+}
+
+void LogicLockingAnalyzer::persist_test_vector_data(std::uint64_t hash, const std::string &name)
+{
+	test_vector_data_->cache_hash = hash;
+	test_vector_data_->cache_name = name;
 }
 
 void LogicLockingAnalyzer::set_input_values(const std::vector<SigBit> &inputs, const std::vector<bool> &values)
@@ -147,128 +203,240 @@ void LogicLockingAnalyzer::set_input_values(const std::vector<SigBit> &inputs, c
 		}
 		++i;
 	}
+	reset_test_vector_data();
 }
 
-void LogicLockingAnalyzer::init_wire_to_cells()
+int LogicLockingAnalyzer::get_input_index(SigBit input) const
 {
-	wire_to_cells_.clear();
-	for (RTLIL::Cell *cell : module_->cells()) {
-		for (auto it : cell->connections()) {
-			if (cell->input(it.first)) {
-				for (SigBit b : it.second) {
-					auto it = wire_to_cells_.insert(b).first;
-					it->second.insert(cell);
-				}
-			}
+	int i = 0;
+	for (SigBit bit : comb_inputs_) {
+		if (bit == input) {
+			return i;
 		}
+		++i;
 	}
+	log_error("Signal is not a combinatorial input of the module\n");
 }
 
-void LogicLockingAnalyzer::init_wire_to_wires()
+void LogicLockingAnalyzer::set_input_values(SigBit input, const std::vector<std::uint64_t> &values)
 {
-	wire_to_wires_.clear();
-	for (auto it : module_->connections()) {
-		SigSpec a = it.first;
-		SigSpec b = it.second;
-		if (GetSize(a) != GetSize(b)) {
-			log_cmd_error("A connection doesn't have same-size signals on both sides");
-			continue;
-		}
-		for (int i = 0; i < GetSize(a); ++i) {
-			SigBit sig_a = a[i];
-			SigBit sig_b = b[i];
-			if (!sig_a.is_wire() || !sig_b.is_wire()) {
-				continue;
+	log_assert(GetSize(values) == nb_test_vectors());
+	int i = get_input_index(input);
+	for (int t = 0; t < nb_test_vectors(); ++t) {
+		test_vectors_[t][i] = values[t];
+	}
+	reset_test_vector_data();
+}
+
+std::vector<bool> LogicLockingAnalyzer::get_test_pattern(int tv, int lane) const
+{
+	std::vector<bool> ret;
+	for (std::uint64_t v : test_vectors_.at(tv)) {
+		ret.push_back((v >> lane) & 1);
+	}
+	return ret;
+}
+
+void LogicLockingAnalyzer::init_signal_ids()
+{
+	// Directly connected bits are aliases of the same signal; the SigMap is only needed during indexing
+	SigMap sigmap(module_);
+	bit_to_id_.clear();
+	nb_signals_ = State::Sm + 1;
+	for (RTLIL::Wire *wire : module_->wires()) {
+		for (SigBit bit : SigSpec(wire)) {
+			SigBit canonical = sigmap(bit);
+			int id;
+			if (!canonical.wire) {
+				id = canonical.data;
+			} else {
+				auto it = bit_to_id_.find(canonical);
+				if (it != bit_to_id_.end()) {
+					id = it->second;
+				} else {
+					id = nb_signals_++;
+					bit_to_id_[canonical] = id;
+				}
 			}
-			if (!wire_to_wires_.count(sig_b)) {
-				wire_to_wires_[sig_b] = pool<SigBit>();
+			bit_to_id_[bit] = id;
+		}
+	}
+	for (auto it : module_->connections()) {
+		for (int i = 0; i < GetSize(it.first); ++i) {
+			if (it.second[i].is_wire() && !it.first[i].is_wire()) {
+				log_warning("Detected connection of wire %s driving a constant; skipped.\n", log_id(it.second[i].wire->name));
 			}
-			wire_to_wires_[sig_b].emplace(sig_a);
-
-			log_debug("Adding direct connection %s --> %s\n", log_id(sig_b.wire->name), log_id(sig_a.wire->name));
 		}
 	}
 }
 
-void LogicLockingAnalyzer::init_aig()
+int LogicLockingAnalyzer::get_signal_id(SigBit bit) const
 {
-	wire_to_aig_.clear();
-	wire_to_driver_.clear();
-	dirty_bits_.clear();
-	aig_ = MiniAIG(comb_inputs_.size());
-	int i = 0;
-	// Handle constants
-	wire_to_aig_.emplace(SigBit(false), Lit::zero());
-	wire_to_aig_.emplace(SigBit(true), Lit::one());
-	for (int s = State::Sx; s < State::Sm; ++s) {
-		wire_to_aig_[SigBit((State)s)] = Lit::zero();
+	if (!bit.wire) {
+		return bit.data;
+	}
+	auto it = bit_to_id_.find(bit);
+	if (it == bit_to_id_.end()) {
+		log_error("Signal %s is not part of module %s\n", log_signal(bit), log_id(module_->name));
+	}
+	return it->second;
+}
+
+Lit LogicLockingAnalyzer::get_aig_literal(SigBit bit) const
+{
+	int id = get_signal_id(bit);
+	if (!id_in_aig_[id]) {
+		log_error("Signal %s has no Aig representation\n", log_signal(bit));
+	}
+	return id_to_aig_[id];
+}
+
+namespace
+{
+std::string bit_name(SigBit bit)
+{
+	if (!bit.wire) {
+		return std::string();
+	}
+	std::string name = RTLIL::unescape_id(bit.wire->name);
+	if (bit.wire->width > 1) {
+		name += stringf("[%d]", bit.offset);
 	}
+	return name;
+}
+} // namespace
+
+void LogicLockingAnalyzer::write_aiger(std::ostream &f) const
+{
+	AigerSymbols symbols;
 	for (SigBit bit : comb_inputs_) {
-		wire_to_aig_.emplace(bit, aig_.getInput(i));
-		log_debug("Adding input %s --> %d\n", log_id(bit.wire->name), aig_.getInput(i).variable());
-		++i;
-		dirty_bits_.insert(bit);
+		symbols.inputs.push_back(bit_name(bit));
+	}
+	for (SigBit bit : comb_outputs_) {
+		symbols.outputs.push_back(bit_name(bit));
+	}
+	for (SigBit bit : get_lockable_signals()) {
+		if (has_aig_literal(bit)) {
+			symbols.togglePoints.emplace_back(bit_name(bit), get_aig_literal(bit));
+		}
 	}
+	writeAiger(f, *aig_, symbols);
+}
 
-	// Handle direct connections to constants
-	for (auto it : module_->connections()) {
-		SigSpec a(it.first);
-		SigSpec b(it.second);
-		for (int i = 0; i < GetSize(a); ++i) {
-			SigBit sig_a = a[i];
-			SigBit sig_b = b[i];
-			if (sig_a.is_wire() && !sig_b.is_wire()) {
-				log_debug("Adding constant wire %s\n", log_id(sig_a.wire->name));
-				wire_to_aig_[sig_a] = sig_b.data == State::S1 ? Lit::one() : Lit::zero();
-				dirty_bits_.emplace(sig_a);
+std::vector<Cell *> LogicLockingAnalyzer::compute_conversion_order() const
+{
+	// Cells reading each signal, in compressed sparse row format, and number of input signals of each cell
+	// that are not yet available; constants are always available
+	std::vector<Cell *> cells;
+	std::vector<int> nb_pending;
+	std::vector<std::pair<int, int>> reads;
+	for (Cell *c : module_->cells()) {
+		std::vector<int> ids;
+		for (auto conn : c->connections()) {
+			if (!c->input(conn.first)) {
+				continue;
 			}
-			if (sig_b.is_wire() && !sig_a.is_wire()) {
-				log_warning("Detected connection of wire %s driving a constant; skipped.\n", log_id(sig_b.wire->name));
+			for (SigBit b : conn.second) {
+				int id = get_signal_id(b);
+				if (id > State::Sm) {
+					ids.push_back(id);
+				}
 			}
 		}
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		for (int id : ids) {
+			reads.emplace_back(id, GetSize(cells));
+		}
+		nb_pending.push_back(GetSize(ids));
+		cells.push_back(c);
 	}
-
-	// Start by processing all cells that can be. Cells that are only driven by constants won't be touched otherwise
-	for (Cell *c : module_->cells()) {
-		// TODO: we could just add the constants to the dirty_bits, and handle them like the rest in wire_to_wires
-		cell_to_aig(c);
+	std::vector<int> reader_start(nb_signals_ + 1, 0);
+	for (auto r : reads) {
+		++reader_start[r.first + 1];
+	}
+	for (int i = 0; i < nb_signals_; ++i) {
+		reader_start[i + 1] += reader_start[i];
+	}
+	std::vector<int> readers(reads.size());
+	std::vector<int> reader_pos(reader_start.begin(), reader_start.end() - 1);
+	for (auto r : reads) {
+		readers[reader_pos[r.first]++] = r.second;
 	}
 
-	// TODO: unify traversal with a single topo sort
-	while (1) {
-		if (dirty_bits_.empty()) {
-			break;
+	// Signals available for conversion, processed in order
+	std::vector<Cell *> order;
+	std::vector<char> reached(nb_signals_, false);
+	std::vector<int> queue;
+	auto reach = [&](int id) {
+		if (!reached[id]) {
+			reached[id] = true;
+			queue.push_back(id);
 		}
-		pool<SigBit> next_dirty;
-		pool<RTLIL::Cell *> dirty_cells;
-		for (SigBit b : dirty_bits_) {
-			for (RTLIL::Cell *cell : wire_to_cells_[b]) {
-				dirty_cells.insert(cell);
-			}
-			// Handle direct connections by adding the connected wires to the dirty list
-			if (wire_to_wires_.count(b)) {
-				for (SigBit c : wire_to_wires_.at(b)) {
-					Lit syn = aig_.addBuffer(wire_to_aig_.at(b));
-					wire_to_aig_[c] = syn;
-					next_dirty.emplace(c);
-					if (wire_to_driver_.count(b)) {
-						Cell *dr = wire_to_driver_.at(b);
-						wire_to_driver_[c] = dr;
-					}
-				}
+	};
+	auto add_cell = [&](Cell *c) {
+		order.push_back(c);
+		if (yosys_celltypes.cell_evaluable(c->type) && c->hasPort(ID::Y) && GetSize(c->getPort(ID::Y)) == 1) {
+			reach(get_signal_id(c->getPort(ID::Y)));
+		}
+	};
+
+	for (SigBit bit : comb_inputs_) {
+		reach(get_signal_id(bit));
+	}
+	// Cells that are only driven by constants
+	for (int i = 0; i < GetSize(cells); ++i) {
+		if (nb_pending[i] == 0) {
+			add_cell(cells[i]);
+		}
+	}
+	for (int i = 0; i < GetSize(queue); ++i) {
+		int id = queue[i];
+		for (int j = reader_start[id]; j < reader_start[id + 1]; ++j) {
+			int c = readers[j];
+			if (--nb_pending[c] == 0) {
+				add_cell(cells[c]);
 			}
 		}
-		dirty_bits_ = next_dirty;
-		for (RTLIL::Cell *cell : dirty_cells) {
-			cell_to_aig(cell);
+	}
+	return order;
+}
+
+void LogicLockingAnalyzer::init_aig()
+{
+	TraceScope trace("init_aig");
+	aig_ = std::make_shared<MiniAIG>(comb_inputs_.size());
+	id_to_aig_.assign(nb_signals_, Lit::zero());
+	id_in_aig_.assign(nb_signals_, false);
+	id_to_driver_.assign(nb_signals_, nullptr);
+
+	// Handle constants; undefined values are handled as zero
+	for (int s = State::S0; s <= State::Sm; ++s) {
+		id_to_aig_[s] = s == State::S1 ? Lit::one() : Lit::zero();
+		id_in_aig_[s] = true;
+	}
+	int i = 0;
+	for (SigBit bit : comb_inputs_) {
+		int id = get_signal_id(bit);
+		if (!id_in_aig_[id]) {
+			id_to_aig_[id] = aig_->getInput(i);
+			id_in_aig_[id] = true;
 		}
+		log_debug("Adding input %s --> %d\n", log_id(bit.wire->name), aig_->getInput(i).variable());
+		++i;
 	}
-	dirty_bits_.clear();
+
+	// Single sweep in topological order
+	cell_order_ = compute_conversion_order();
+	for (Cell *c : cell_order_) {
+		cell_to_aig(c);
+	}
+
 
 	report_conversion_issues();
 
 	for (SigBit bit : comb_outputs_) {
-		if (!wire_to_aig_.count(bit)) {
+		if (!has_aig_literal(bit)) {
 			if (bit.wire) {
 				log_error("Missing output %s\n", log_id(bit.wire->name));
 			} else {
@@ -277,14 +445,74 @@ void LogicLockingAnalyzer::init_aig()
 		}
 
 		if (bit.wire) {
-			log_debug("Adding output %s --> %d\n", log_id(bit.wire->name), wire_to_aig_.at(bit).variable());
+			log_debug("Adding output %s --> %d\n", log_id(bit.wire->name), get_aig_literal(bit).variable());
 		} else {
 			log_debug("Adding constant output\n");
 		}
-		aig_.addOutput(wire_to_aig_.at(bit));
+		aig_->addOutput(get_aig_literal(bit));
+	}
+	aig_->setupIncremental();
+	aig_->check();
+	trace.addCounter("cells", GetSize(cell_order_));
+	trace.addCounter("nodes", aig_->nbNodes());
+}
+
+void LogicLockingAnalyzer::sweep_aig(bool keep_signals)
+{
+	TraceScope trace("sweep_aig");
+	int nb_inputs = aig_->nbInputs();
+	std::vector<char> frozen(nb_inputs + aig_->nbNodes() + 1, 0);
+	int nb_frozen = 0;
+	if (keep_signals) {
+		// Only the lockable signals are toggled by the analyses; other signals may be merged
+		for (SigBit bit : get_lockable_signals()) {
+			if (!has_aig_literal(bit)) {
+				continue;
+			}
+			int var = get_aig_literal(bit).variable();
+			if (var > nb_inputs && !frozen[var]) {
+				frozen[var] = 1;
+				++nb_frozen;
+			}
+		}
+	}
+	// The Aig may be shared with copies of the analyzer: work on a new one
+	std::shared_ptr<MiniAIG> aig;
+	if (nb_frozen == aig_->nbNodes()) {
+		// Every node is a lockable signal and nothing can be merged
+		aig = std::make_shared<MiniAIG>(*aig_);
+	} else {
+		AigSweeper sweeper(*aig_, frozen);
+		sweeper.run();
+		int nb_removed = aig_->nbNodes() - sweeper.result().nbNodes();
+		trace.addCounter("removed", nb_removed);
+		trace.addCounter("aborted_checks", sweeper.nbAbortedChecks());
+		if (nb_removed > 0) {
+			log("Sweeping removed %d out of %d AIG nodes: %d structural, %d equivalent, %d constant.\n", nb_removed, aig_->nbNodes(),
+			    sweeper.nbStructural(), sweeper.nbMerged(), sweeper.nbConstants());
+		}
+		if (sweeper.nbAbortedChecks() > 0) {
+			log("Sweeping left %d candidate equivalences unproven because of the time budget.\n", sweeper.nbAbortedChecks());
+		}
+		aig = std::make_shared<MiniAIG>(sweeper.result());
+		for (int id = 0; id < nb_signals_; ++id) {
+			if (id_in_aig_[id]) {
+				id_to_aig_[id] = sweeper.mapLit(id_to_aig_[id]);
+			}
+		}
 	}
-	aig_.setupIncremental();
-	aig_.check();
+	trace.addCounter("nodes", aig->nbNodes());
+
+	// Renumber the nodes so that the cones simulated together are close in memory
+	std::vector<Lit> order = aig->renumberDfs();
+	for (int id = 0; id < nb_signals_; ++id) {
+		if (id_in_aig_[id]) {
+			Lit l = id_to_aig_[id];
+			id_to_aig_[id] = l.polarity() ? order[l.variable()].inv() : order[l.variable()];
+		}
+	}
+	aig_ = aig;
+	reset_test_vector_data();
 }
 
 void LogicLockingAnalyzer::report_conversion_issues() const
@@ -292,14 +520,14 @@ void LogicLockingAnalyzer::report_conversion_issues() const
 	for (auto c : module_->cells()) {
 		if (c->hasPort(ID::Y)) {
 			SigBit output = c->getPort(ID::Y);
-			if (wire_to_aig_.count(output)) {
+			if (has_aig_literal(output)) {
 				continue;
 			}
 			for (auto conn : c->connections()) {
 				auto id = conn.first;
 				if (c->input(id)) {
 					SigBit input = conn.second;
-					if (!wire_to_aig_.count(input)) {
+					if (!has_aig_literal(input)) {
 						if (input.wire) {
 							log("Missing port %s on cell %s (output %s) with wire %s\n", log_id(id), log_id(c->name),
 							    log_id(output.wire->name), log_id(input.wire->name));
@@ -323,7 +551,7 @@ bool LogicLockingAnalyzer::has_valid_port(Cell *cell, const IdString &port_name)
 	if (spec.size() != 1) {
 		return false;
 	}
-	return wire_to_aig_.count(spec);
+	return has_aig_literal(spec);
 }
 
 void LogicLockingAnalyzer::cell_to_aig(Cell *cell)
@@ -342,15 +570,15 @@ void LogicLockingAnalyzer::cell_to_aig(Cell *cell)
 	has_y = has_valid_port(cell, ID::Y);
 
 	if (has_a)
-		sig_a = wire_to_aig_.at(cell->getPort(ID::A));
+		sig_a = get_aig_literal(cell->getPort(ID::A));
 	if (has_b)
-		sig_b = wire_to_aig_.at(cell->getPort(ID::B));
+		sig_b = get_aig_literal(cell->getPort(ID::B));
 	if (has_c)
-		sig_c = wire_to_aig_.at(cell->getPort(ID::C));
+		sig_c = get_aig_literal(cell->getPort(ID::C));
 	if (has_d)
-		sig_d = wire_to_aig_.at(cell->getPort(ID::D));
+		sig_d = get_aig_literal(cell->getPort(ID::D));
 	if (has_s)
-		sig_s = wire_to_aig_.at(cell->getPort(ID::S));
+		sig_s = get_aig_literal(cell->getPort(ID::S));
 
 	if (has_y) {
 		return;
@@ -359,76 +587,76 @@ void LogicLockingAnalyzer::cell_to_aig(Cell *cell)
 	if (cell->type.in(ID($not), ID($_NOT_), ID($pos), ID($_BUF_))) {
 		if (has_a) {
 			bool inv = cell->type.in(ID($not), ID($_NOT_));
-			Lit res = aig_.addBuffer(inv ? sig_a.inv() : sig_a);
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			Lit res = aig_->addBuffer(inv ? sig_a.inv() : sig_a);
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($and), ID($_AND_), ID($_NAND_), ID($or), ID($_OR_), ID($_NOR_), ID($xor), ID($xnor), ID($_XOR_), ID($_XNOR_),
 				 ID($_ANDNOT_), ID($_ORNOT_))) {
 		if (has_a && has_b) {
 			Lit res;
 			if (cell->type.in(ID($and), ID($_AND_)))
-				res = aig_.addAnd(sig_a, sig_b);
+				res = aig_->addAnd(sig_a, sig_b);
 			else if (cell->type.in(ID($_NAND_)))
-				res = aig_.addNand(sig_a, sig_b);
+				res = aig_->addNand(sig_a, sig_b);
 			else if (cell->type.in(ID($or), ID($_OR_)))
-				res = aig_.addOr(sig_a, sig_b);
+				res = aig_->addOr(sig_a, sig_b);
 			else if (cell->type.in(ID($_NOR_)))
-				res = aig_.addNor(sig_a, sig_b);
+				res = aig_->addNor(sig_a, sig_b);
 			else if (cell->type.in(ID($xor), ID($_XOR_)))
-				res = aig_.addXor(sig_a, sig_b);
+				res = aig_->addXor(sig_a, sig_b);
 			else if (cell->type.in(ID($xnor), ID($_XNOR_)))
-				res = aig_.addXnor(sig_a, sig_b);
+				res = aig_->addXnor(sig_a, sig_b);
 			else if (cell->type.in(ID($_ANDNOT_)))
-				res = aig_.addAnd(sig_a, sig_b.inv());
+				res = aig_->addAnd(sig_a, sig_b.inv());
 			else if (cell->type.in(ID($_ORNOT_)))
-				res = aig_.addOr(sig_a, sig_b.inv());
+				res = aig_->addOr(sig_a, sig_b.inv());
 			else
 				log_cmd_error("Cell type %s not handled", log_id(cell->type));
 
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($mux), ID($_MUX_), ID($_NMUX_))) {
 		if (has_a && has_b && has_s) {
-			Lit res = aig_.addMux(sig_s, sig_a, sig_b);
+			Lit res = aig_->addMux(sig_s, sig_a, sig_b);
 			if (cell->type.in(ID($_NMUX))) {
 				res = res.inv();
 			}
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($_AOI3_))) {
 		if (has_a && has_b && has_c) {
-			Lit res = aig_.addNor(aig_.addAnd(sig_a, sig_b), sig_c);
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			Lit res = aig_->addNor(aig_->addAnd(sig_a, sig_b), sig_c);
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($_OAI3_))) {
 		if (has_a && has_b && has_c) {
-			Lit res = aig_.addNand(aig_.addOr(sig_a, sig_b), sig_c);
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			Lit res = aig_->addNand(aig_->addOr(sig_a, sig_b), sig_c);
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($_AOI4_))) {
 		if (has_a && has_b && has_c && has_d) {
-			Lit res = aig_.addNor(aig_.addAnd(sig_a, sig_b), aig_.addAnd(sig_c, sig_d));
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			Lit res = aig_->addNor(aig_->addAnd(sig_a, sig_b), aig_->addAnd(sig_c, sig_d));
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else if (cell->type.in(ID($_OAI4_))) {
 		if (has_a && has_b && has_c && has_d) {
-			Lit res = aig_.addNand(aig_.addOr(sig_a, sig_b), aig_.addOr(sig_c, sig_d));
-			wire_to_aig_[cell->getPort(ID::Y)] = res;
-			dirty_bits_.insert(cell->getPort(ID::Y));
+			Lit res = aig_->addNand(aig_->addOr(sig_a, sig_b), aig_->addOr(sig_c, sig_d));
+			id_to_aig_[get_signal_id(cell->getPort(ID::Y))] = res;
+			id_in_aig_[get_signal_id(cell->getPort(ID::Y))] = true;
 		}
 	} else {
 		log_cmd_error("Cell %s has type %s which is not supported. Did you run synthesis before?\n", log_id(cell->name), log_id(cell->type));
 	}
-	if (wire_to_aig_.count(cell->getPort(ID::Y))) {
+	if (has_aig_literal(cell->getPort(ID::Y))) {
 		log_debug("Converting cell %s of type %s, wire %s\n", log_id(cell->name), log_id(cell->type),
 			  log_id(cell->getPort(ID::Y).as_bit().wire->name));
-		wire_to_driver_[cell->getPort(ID::Y)] = cell;
+		id_to_driver_[get_signal_id(cell->getPort(ID::Y))] = cell;
 	}
 }
 
@@ -443,159 +671,84 @@ RTLIL::State invert_state(RTLIL::State val)
 	}
 }
 
-void LogicLockingAnalyzer::set_input_state(const dict<SigBit, State> &state)
-{
-	state_ = state;
-	dirty_bits_.clear();
-	for (auto &it : state_) {
-		if (toggled_bits_.count(it.first)) {
-			it.second = invert_state(it.second);
-		}
-		dirty_bits_.insert(it.first);
-	}
-
-	// Handle direct connections to constants
-	for (auto it : module_->connections()) {
-		SigBit a(it.first);
-		SigBit b(it.second);
-		if (a.is_wire() && !b.is_wire()) {
-			state_[a] = b.data;
-			dirty_bits_.insert(a);
-		}
-		if (b.is_wire() && !a.is_wire()) {
-			state_[b] = a.data;
-			dirty_bits_.insert(b);
-		}
-	}
-}
-
-dict<SigBit, State> LogicLockingAnalyzer::get_output_state() const
-{
-	dict<SigBit, State> ret;
-	for (RTLIL::Wire *wire : module_->wires()) {
-		if (!wire->port_output) {
-			continue;
-		}
-		SigBit bit(wire);
-		if (state_.count(bit)) {
-			ret[bit] = state_.at(bit);
-		} else {
-			log_error("Signal not found in output %s\n", log_id(wire->name));
-		}
-	}
-	for (RTLIL::Cell *cell : module_->cells()) {
-		if (!yosys_celltypes.cell_evaluable(cell->type)) {
-			for (auto it : cell->connections()) {
-				if (cell->input(it.first)) {
-					SigBit bit = it.second.as_bit();
-					if (state_.count(bit)) {
-						ret[bit] = state_.at(bit);
-					} else {
-						log_error("Signal not found in cell input %s\n", log_id(cell->name));
-					}
-				}
-			}
-		}
-	}
-	return ret;
-}
-
-bool LogicLockingAnalyzer::has_state(SigSpec sig)
+bool LogicLockingAnalyzer::has_state(const CellSimState &sim, SigSpec sig) const
 {
 	for (auto bit : sig)
-		if (bit.wire != nullptr && !state_.count(bit))
+		if (bit.wire != nullptr && sim.state[get_signal_id(bit)] == State::Sm)
 			return false;
 	return true;
 }
 
-RTLIL::Const LogicLockingAnalyzer::get_state(SigSpec sig)
+RTLIL::Const LogicLockingAnalyzer::get_state(const CellSimState &sim, SigSpec sig) const
 {
 	RTLIL::Const value;
 
 	for (auto bit : sig)
 		if (bit.wire == nullptr)
 			value.bits.push_back(bit.data);
-		else if (state_.count(bit))
-			value.bits.push_back(state_.at(bit));
+		else if (sim.state[get_signal_id(bit)] != State::Sm)
+			value.bits.push_back(sim.state[get_signal_id(bit)]);
 		else
 			value.bits.push_back(State::Sz);
 
 	return value;
 }
 
-void LogicLockingAnalyzer::set_state(SigSpec sig, RTLIL::Const value)
+void LogicLockingAnalyzer::set_state(CellSimState &sim, SigSpec sig, RTLIL::Const value) const
 {
 	log_assert(GetSize(sig) <= GetSize(value));
 
 	for (int i = 0; i < GetSize(sig); i++)
 		if (value[i] != State::Sa) {
+			int id = get_signal_id(sig[i]);
+			if (id <= State::Sm) {
+				// Cell driving a wire connected to a constant
+				continue;
+			}
 			State val = value[i];
-			if (toggled_bits_.count(sig[i])) {
+			if (sim.toggled[id]) {
 				val = invert_state(val);
 			}
-			state_[sig[i]] = val;
-			dirty_bits_.insert(sig[i]);
+			sim.state[id] = val;
 		}
 }
 
-std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_basic(int tv, const pool<SigBit> &toggled_bits)
+std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_basic(int tv, const pool<SigBit> &toggled_bits) const
 {
 	std::vector<std::uint64_t> ret(comb_outputs_.size());
+	CellSimState sim;
+	sim.toggled.assign(nb_signals_, false);
+	for (SigBit bit : toggled_bits) {
+		sim.toggled[get_signal_id(bit)] = true;
+	}
 	// Execute bit after bit
 	for (int ind = 0; ind < 64; ++ind) {
-		dict<SigBit, State> input_state;
+		sim.state.assign(nb_signals_, State::Sm);
+		for (int s = State::S0; s <= State::Sm; ++s) {
+			sim.state[s] = s == State::S1 ? State::S1 : State::S0;
+		}
 		int j = 0;
 		for (SigBit inp : comb_inputs_) {
 			bool bit = (test_vectors_[tv][j] >> ind) & 1;
-			input_state[inp] = bit ? State::S1 : State::S0;
+			State val = bit ? State::S1 : State::S0;
+			int id = get_signal_id(inp);
+			sim.state[id] = sim.toggled[id] ? invert_state(val) : val;
 			++j;
 		}
-		toggled_bits_ = toggled_bits;
-		set_input_state(input_state);
-		while (1) {
-			if (dirty_bits_.empty()) {
-				break;
-			}
-			pool<SigBit> next_dirty;
-			pool<RTLIL::Cell *> dirty_cells;
-			for (SigBit b : dirty_bits_) {
-				for (RTLIL::Cell *cell : wire_to_cells_[b]) {
-					dirty_cells.insert(cell);
-				}
-				// Handle direct connections by adding the connected wires to the dirty list
-				if (wire_to_wires_.count(b)) {
-					for (SigBit c : wire_to_wires_[b]) {
-						if (!state_.count(c)) {
-							state_[c] = state_[b];
-							next_dirty.emplace(c);
-						}
-					}
-				}
-			}
-			dirty_bits_ = next_dirty;
-			for (RTLIL::Cell *cell : dirty_cells) {
-				simulate_cell(cell);
-			}
+		// Cells are already sorted topologically
+		for (Cell *cell : cell_order_) {
+			simulate_cell(sim, cell);
 		}
 		for (RTLIL::Wire *wire : module_->wires()) {
-			SigBit bit(wire);
-			if (!state_.count(bit)) {
-				log_error("\tWire %s not simulated\n", log_id(wire->name));
-			}
-		}
-		for (auto it : wire_to_aig_) {
-			State val = state_[it.first];
-			std::uint64_t aig_val = aig_.getValue(it.second);
-			if (val != State::S0) {
-				aig_val |= ((std::uint64_t)1) << ind;
+			for (SigBit bit : SigSpec(wire)) {
+				if (!has_state(sim, bit)) {
+					log_error("\tWire %s not simulated\n", log_id(wire->name));
+				}
 			}
-			aig_.setValue(it.second, aig_val);
 		}
-		dict<SigBit, State> output_state = get_output_state();
 		j = 0;
 		for (SigBit outp : comb_outputs_) {
-			State out_val = output_state.at(outp);
-			if (out_val != State::S0) {
+			if (sim.state[get_signal_id(outp)] != State::S0) {
 				ret[j] |= ((std::uint64_t)1) << ind;
 			}
 			++j;
@@ -604,13 +757,13 @@ std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_basic(int tv, const po
 	return ret;
 }
 
-std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_aig(int tv, const pool<SigBit> &toggled_bits)
+std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_aig(SimContext &sim, int tv, const pool<SigBit> &toggled_bits) const
 {
 	std::vector<Lit> toggling;
 	for (SigBit bit : toggled_bits) {
-		toggling.push_back(wire_to_aig_.at(bit));
+		toggling.push_back(get_aig_literal(bit));
 	}
-	auto ret = aig_.simulateWithToggling(test_vectors_[tv], toggling);
+	auto ret = sim.simulateWithToggling(test_vectors_[tv], toggling);
 	if (check_sim) {
 		auto ret_checked = simulate_basic(tv, toggled_bits);
 		if (ret_checked != ret) {
@@ -620,7 +773,7 @@ std::vector<std::uint64_t> LogicLockingAnalyzer::simulate_aig(int tv, const pool
 	return ret;
 }
 
-void LogicLockingAnalyzer::simulate_cell(RTLIL::Cell *cell)
+void LogicLockingAnalyzer::simulate_cell(CellSimState &sim, RTLIL::Cell *cell) const
 {
 	// Taken from passes/sat/sim.cc
 	if (yosys_celltypes.cell_evaluable(cell->type)) {
@@ -649,33 +802,33 @@ void LogicLockingAnalyzer::simulate_cell(RTLIL::Cell *cell)
 
 		// Simple (A -> Y) and (A,B -> Y) cells
 		if (has_a && !has_c && !has_d && !has_s && has_y) {
-			if (!has_state(sig_a) || !has_state(sig_b))
+			if (!has_state(sim, sig_a) || !has_state(sim, sig_b))
 				return;
-			set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b)));
+			set_state(sim, sig_y, CellTypes::eval(cell, get_state(sim, sig_a), get_state(sim, sig_b)));
 			return;
 		}
 
 		// (A,B,C -> Y) cells
 		if (has_a && has_b && has_c && !has_d && !has_s && has_y) {
-			if (!has_state(sig_a) || !has_state(sig_b) || !has_state(sig_c))
+			if (!has_state(sim, sig_a) || !has_state(sim, sig_b) || !has_state(sim, sig_c))
 				return;
-			set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_c)));
+			set_state(sim, sig_y, CellTypes::eval(cell, get_state(sim, sig_a), get_state(sim, sig_b), get_state(sim, sig_c)));
 			return;
 		}
 
 		// (A,S -> Y) cells
 		if (has_a && !has_b && !has_c && !has_d && has_s && has_y) {
-			if (!has_state(sig_a) || !has_state(sig_s))
+			if (!has_state(sim, sig_a) || !has_state(sim, sig_s))
 				return;
-			set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_s)));
+			set_state(sim, sig_y, CellTypes::eval(cell, get_state(sim, sig_a), get_state(sim, sig_s)));
 			return;
 		}
 
 		// (A,B,S -> Y) cells
 		if (has_a && has_b && !has_c && !has_d && has_s && has_y) {
-			if (!has_state(sig_a) || !has_state(sig_b) || !has_state(sig_s))
+			if (!has_state(sim, sig_a) || !has_state(sim, sig_b) || !has_state(sim, sig_s))
 				return;
-			set_state(sig_y, CellTypes::eval(cell, get_state(sig_a), get_state(sig_b), get_state(sig_s)));
+			set_state(sim, sig_y, CellTypes::eval(cell, get_state(sim, sig_a), get_state(sim, sig_b), get_state(sim, sig_s)));
 			return;
 		}
 
@@ -719,19 +872,20 @@ std::vector<std::uint64_t> LogicLockingAnalyzer::mergeOutputCorruptionData(const
 	return ret;
 }
 
-std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_corruption_data(SigBit a)
+std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_corruption_data(SigBit a) const
 {
 	pool<SigBit> toggled_bits;
 	toggled_bits.insert(a);
 	return compute_output_corruption_data(toggled_bits);
 }
 
-std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_corruption_data(const pool<SigBit> &toggled_bits)
+std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_corruption_data(const pool<SigBit> &toggled_bits) const
 {
 	std::vector<std::vector<std::uint64_t>> ret(comb_outputs_.size());
+	SimContext sim(*aig_);
 	for (int i = 0; i < nb_test_vectors(); ++i) {
-		auto no_toggle = simulate_aig(i, {});
-		auto toggle = simulate_aig(i, toggled_bits);
+		auto no_toggle = simulate_aig(sim, i, {});
+		auto toggle = simulate_aig(sim, i, toggled_bits);
 
 		for (size_t i = 0; i < no_toggle.size(); ++i) {
 			std::uint64_t t = toggle[i] ^ no_toggle[i];
@@ -745,26 +899,23 @@ dict<Cell *, std::vector<std::vector<std::uint64_t>>> LogicLockingAnalyzer::comp
 {
 	std::vector<SigBit> signals = get_lockable_signals();
 	std::vector<Cell *> cells = get_lockable_cells();
-
-	std::vector<Lit> toggles;
-	for (int i = 0; i < GetSize(signals); ++i) {
-		toggles.push_back(wire_to_aig_.at(signals[i]));
-	}
-
-	std::vector<std::vector<std::vector<std::uint64_t>>> corr(signals.size(), std::vector<std::vector<std::uint64_t>>(nb_outputs()));
-	for (int i = 0; i < nb_test_vectors(); ++i) {
-		auto no_toggle = aig_.simulate(test_vectors_[i]);
-		assert((int)no_toggle.size() == nb_outputs());
-		aig_.copyIncrementalState();
-		for (int j = 0; j < GetSize(signals); ++j) {
-			auto toggle = aig_.simulateIncremental(toggles[j]);
-
-			for (size_t k = 0; k < no_toggle.size(); ++k) {
-				std::uint64_t t = toggle[k] ^ no_toggle[k];
-				corr.at(j).at(k).push_back(t);
+	TestVectorData &data = *test_vector_data_;
+	if (data.corruption.empty()) {
+		std::string path;
+		if (!data.cache_name.empty()) {
+			path = AnalysisCache::artifact_path(data.cache_hash, data.cache_name + "-corruption");
+		}
+		if (!path.empty() && AnalysisCache::load_corruption(path, data.cache_hash, data.corruption) &&
+		    GetSize(data.corruption) == GetSize(signals)) {
+			log("Loaded the corruption data of module %s from %s.\n", log_id(module_->name), path.c_str());
+		} else {
+			data.corruption = compute_output_corruption_data_per_signal(signals);
+			if (!path.empty()) {
+				AnalysisCache::save_corruption(path, data.cache_hash, data.corruption);
 			}
 		}
 	}
+	const auto &corr = data.corruption;
 
 	dict<Cell *, std::vector<std::vector<std::uint64_t>>> ret;
 	for (int i = 0; i < GetSize(signals); ++i) {
@@ -773,26 +924,44 @@ dict<Cell *, std::vector<std::vector<std::uint64_t>>> LogicLockingAnalyzer::comp
 	return ret;
 }
 
-std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_value()
+std::vector<std::vector<std::vector<std::uint64_t>>> LogicLockingAnalyzer::compute_output_corruption_data_per_signal(const std::vector<SigBit> &signals) const
+{
+	std::vector<Lit> toggles;
+	for (int i = 0; i < GetSize(signals); ++i) {
+		toggles.push_back(get_aig_literal(signals[i]));
+	}
+
+	return computeOutputCorruption(*aig_, test_vectors_, toggles);
+}
+
+std::vector<std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_output_value() const
 {
 	std::vector<std::vector<std::uint64_t>> ret(nb_outputs());
+	SimContext sim(*aig_);
 	for (int i = 0; i < nb_test_vectors(); ++i) {
-		auto no_toggle = aig_.simulate(test_vectors_[i]);
+		auto no_toggle = sim.simulate(test_vectors_[i]);
 		assert((int)no_toggle.size() == nb_outputs());
 		for (int j = 0; j < nb_outputs(); ++j) {
-			ret[j].push_back(no_toggle[i]);
+			ret[j].push_back(no_toggle[j]);
 		}
 	}
 	return ret;
 }
 
-std::vector<bool> LogicLockingAnalyzer::compute_output_value(const std::vector<bool> &inputs)
+std::vector<bool> LogicLockingAnalyzer::compute_output_value(const std::vector<bool> &inputs) const
+{
+	SimContext sim(*aig_);
+	return compute_output_value(sim, inputs);
+}
+
+std::vector<bool> LogicLockingAnalyzer::compute_output_value(SimContext &sim, const std::vector<bool> &inputs) const
 {
+	log_assert(&sim.aig() == aig_.get());
 	std::vector<std::uint64_t> i64_in;
 	for (bool b : inputs) {
 		i64_in.push_back(b ? (std::uint64_t)-1 : (std::uint64_t)0);
 	}
-	auto res = aig_.simulate(i64_in);
+	auto res = sim.simulate(i64_in);
 	std::vector<bool> ret(nb_outputs());
 	for (int j = 0; j < nb_outputs(); ++j) {
 		ret[j] = res[j] != 0;
@@ -800,7 +969,7 @@ std::vector<bool> LogicLockingAnalyzer::compute_output_value(const std::vector<b
 	return ret;
 }
 
-dict<Cell *, std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_internal_value_per_signal()
+dict<Cell *, std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_internal_value_per_signal() const
 {
 	std::vector<SigBit> signals = get_lockable_signals();
 	std::vector<Cell *> cells = get_lockable_cells();
@@ -809,25 +978,33 @@ dict<Cell *, std::vector<std::uint64_t>> LogicLockingAnalyzer::compute_internal_
 	for (int i = 0; i < GetSize(signals); ++i) {
 		ret.emplace(cells[i], std::vector<std::uint64_t>());
 	}
+	SimContext sim(*aig_);
 	for (int i = 0; i < nb_test_vectors(); ++i) {
-		aig_.simulate(test_vectors_[i]);
+		sim.simulate(test_vectors_[i]);
 		for (int s = 0; s < GetSize(signals); ++s) {
-			Lit l = wire_to_aig_.at(signals[s]);
-			std::uint64_t val = aig_.getValue(l);
+			Lit l = get_aig_literal(signals[s]);
+			std::uint64_t val = sim.getValue(l);
 			ret[cells[s]].push_back(val);
 		}
 	}
 	return ret;
 }
 
-bool LogicLockingAnalyzer::is_pairwise_secure(SigBit a, SigBit b, bool ignore_duplicates)
+bool LogicLockingAnalyzer::is_pairwise_secure(SigBit a, SigBit b, bool ignore_duplicates) const
+{
+	SimContext sim(*aig_);
+	return is_pairwise_secure(sim, a, b, ignore_duplicates);
+}
+
+bool LogicLockingAnalyzer::is_pairwise_secure(SimContext &sim, SigBit a, SigBit b, bool ignore_duplicates) const
 {
+	log_assert(&sim.aig() == aig_.get());
 	bool same_impact = true;
 	for (int i = 0; i < nb_test_vectors(); ++i) {
-		auto no_toggle = simulate_aig(i, {});
-		auto toggle_a = simulate_aig(i, {a});
-		auto toggle_b = simulate_aig(i, {b});
-		auto toggle_both = simulate_aig(i, {a, b});
+		auto no_toggle = simulate_aig(sim, i, {});
+		auto toggle_a = simulate_aig(sim, i, {a});
+		auto toggle_b = simulate_aig(sim, i, {b});
+		auto toggle_both = simulate_aig(sim, i, {a, b});
 
 		for (size_t i = 0; i < no_toggle.size(); ++i) {
 			std::uint64_t state_none = no_toggle[i];
@@ -849,21 +1026,56 @@ bool LogicLockingAnalyzer::is_pairwise_secure(SigBit a, SigBit b, bool ignore_du
 	return !ignore_duplicates || !same_impact;
 }
 
-std::vector<std::pair<Cell *, Cell *>> LogicLockingAnalyzer::compute_pairwise_secure_graph(bool ignore_duplicates)
+const std::vector<std::pair<int, int>> &LogicLockingAnalyzer::compute_pairwise_secure_indices(bool ignore_duplicates)
 {
+	TestVectorData &data = *test_vector_data_;
+	std::vector<std::pair<int, int>> &edges = data.pairwise[ignore_duplicates];
+	if (data.has_pairwise[ignore_duplicates]) {
+		return edges;
+	}
 	std::vector<SigBit> signals = get_lockable_signals();
 	std::vector<Cell *> cells = get_lockable_cells();
+	data.has_pairwise[ignore_duplicates] = true;
+
+	std::string path;
+	if (!data.cache_name.empty()) {
+		path = AnalysisCache::artifact_path(data.cache_hash, data.cache_name + (ignore_duplicates ? "-pairwise" : "-pairwise-all"));
+		if (AnalysisCache::load_pairwise(path, data.cache_hash, edges) &&
+		    std::all_of(edges.begin(), edges.end(), [&](std::pair<int, int> e) {
+			    return e.first >= 0 && e.second >= 0 && e.first < GetSize(signals) && e.second < GetSize(signals);
+		    })) {
+			log("Loaded the pairwise security graph of module %s from %s.\n", log_id(module_->name), path.c_str());
+			return edges;
+		}
+	}
 
-	std::vector<std::pair<Cell *, Cell *>> ret;
+	TraceScope trace("pairwise_graph");
+	edges.clear();
+	SimContext sim(*aig_);
 	for (int i = 0; i < GetSize(signals); ++i) {
 		log_debug("\tSimulating %s (%d/%d)\n", log_id(cells[i]->name), i + 1, GetSize(signals));
 		for (int j = i + 1; j < GetSize(signals); ++j) {
-			if (is_pairwise_secure(signals[i], signals[j], ignore_duplicates)) {
-				ret.emplace_back(cells[i], cells[j]);
+			if (is_pairwise_secure(sim, signals[i], signals[j], ignore_duplicates)) {
+				edges.emplace_back(i, j);
 				log_debug("\t\tPairwise secure %s <-> %s\n", log_id(cells[i]->name), log_id(cells[j]->name));
 			}
 		}
 	}
+	trace.addCounter("signals", GetSize(signals));
+	trace.addCounter("pairs", GetSize(edges));
+	if (!path.empty()) {
+		AnalysisCache::save_pairwise(path, data.cache_hash, edges);
+	}
+	return edges;
+}
+
+std::vector<std::pair<Cell *, Cell *>> LogicLockingAnalyzer::compute_pairwise_secure_graph(bool ignore_duplicates)
+{
+	std::vector<Cell *> cells = get_lockable_cells();
+	std::vector<std::pair<Cell *, Cell *>> ret;
+	for (auto e : compute_pairwise_secure_indices(ignore_duplicates)) {
+		ret.emplace_back(cells[e.first], cells[e.second]);
+	}
 	dict<Cell *, int> nb_secure;
 	for (auto p : ret) {
 		if (!nb_secure.count(p.first)) {
@@ -886,10 +1098,9 @@ std::vector<std::pair<Cell *, Cell *>> LogicLockingAnalyzer::compute_dependency_
 	std::vector<std::pair<Cell *, Cell *>> ret;
 	for (Cell *cell : module_->cells()) {
 		for (auto conn : cell->connections()) {
-			SigBit b = conn.second;
-			if (wire_to_driver_.count(b)) {
-				Cell *dep = wire_to_driver_.at(b);
-				if (dep != cell) {
+			for (SigBit b : conn.second) {
+				Cell *dep = id_to_driver_[get_signal_id(b)];
+				if (dep != nullptr && dep != cell) {
 					ret.emplace_back(dep, cell);
 				}
 			}
@@ -1071,3 +1282,19 @@ std::vector<double> LogicLockingAnalyzer::compute_KIP(const std::vector<Cell *>
 	}
 	return ret;
 }
+
+std::vector<double> LogicLockingAnalyzer::compute_cop_observability(const std::vector<Cell *> &cells) const
+{
+	std::vector<SigBit> signals = get_lockable_signals();
+	std::vector<Cell *> lockable = get_lockable_cells();
+	dict<Cell *, SigBit> cell_to_signal;
+	for (int i = 0; i < GetSize(signals); ++i) {
+		cell_to_signal.emplace(lockable[i], signals[i]);
+	}
+	CopTestability cop(*aig_);
+	std::vector<double> ret;
+	for (Cell *c : cells) {
+		ret.push_back(cop.observability(get_aig_literal(cell_to_signal.at(c))));
+	}
+	return ret;
+}
@@ -13,6 +13,9 @@
 #include "output_corruption_optimizer.hpp"
 #include "pairwise_security_optimizer.hpp"
 
+#include <iosfwd>
+#include <memory>
+
 using Yosys::dict;
 using Yosys::pool;
 using Yosys::RTLIL::Cell;
@@ -66,6 +69,13 @@ class LogicLockingAnalyzer
 	 */
 	explicit LogicLockingAnalyzer(Module *module);
 
+	/**
+	 * @brief Initialize with a module, loading the Aig from the persistent cache if available, and saving it otherwise
+	 *
+	 * @param hash Canonical hash of the module, as given by AnalysisCache
+	 */
+	LogicLockingAnalyzer(Module *module, std::uint64_t hash);
+
 	/**
 	 * @brief Number of inputs of the circuit
 	 */
@@ -86,6 +96,16 @@ class LogicLockingAnalyzer
 	 */
 	void gen_test_vectors(int nb, size_t seed);
 
+	/**
+	 * @brief Persist the corruption and pairwise security data computed from the current test vectors
+	 *
+	 * The data is loaded from the cache if already available. This only applies until the test vectors are modified.
+	 *
+	 * @param hash Canonical hash of the module, as given by AnalysisCache
+	 * @param name Name of the test vector configuration, that must identify how the test vectors were generated
+	 */
+	void persist_test_vector_data(std::uint64_t hash, const std::string &name);
+
 	/**
 	 * @brief Flatten corruption information that is originally per-output per-test-vector
 	 */
@@ -104,32 +124,42 @@ class LogicLockingAnalyzer
 	/**
 	 * @brief Returns the impact of toggling this signal (per output per test vector)
 	 */
-	std::vector<std::vector<std::uint64_t>> compute_output_corruption_data(SigBit a);
+	std::vector<std::vector<std::uint64_t>> compute_output_corruption_data(SigBit a) const;
 
 	/**
 	 * @brief Returns the impact of toggling all these signals (per output per test vector)
 	 */
-	std::vector<std::vector<std::uint64_t>> compute_output_corruption_data(const pool<SigBit> &toggled_bits);
+	std::vector<std::vector<std::uint64_t>> compute_output_corruption_data(const pool<SigBit> &toggled_bits) const;
 
 	/**
 	 * @brief Returns the impact of locking each cell (per output per test vector)
 	 */
 	dict<Cell *, std::vector<std::vector<std::uint64_t>>> compute_output_corruption_data_per_signal();
 
+	/**
+	 * @brief Returns the impact of toggling each of these signals in turn (per signal per output per test vector)
+	 */
+	std::vector<std::vector<std::vector<std::uint64_t>>> compute_output_corruption_data_per_signal(const std::vector<SigBit> &signals) const;
+
 	/**
 	 * @brief Returns the value of each cell output when not locked (per test vector)
 	 */
-	dict<Cell *, std::vector<std::uint64_t>> compute_internal_value_per_signal();
+	dict<Cell *, std::vector<std::uint64_t>> compute_internal_value_per_signal() const;
 
 	/**
 	 * @brief Returns the value of each output when no locking is applied (per test vector)
 	 */
-	std::vector<std::vector<std::uint64_t>> compute_output_value();
+	std::vector<std::vector<std::uint64_t>> compute_output_value() const;
 
 	/**
 	 * @brief Returns the value of each output on a single test vector when no locking is applied
 	 */
-	std::vector<bool> compute_output_value(const std::vector<bool> &inputs);
+	std::vector<bool> compute_output_value(const std::vector<bool> &inputs) const;
+
+	/**
+	 * @brief Returns the value of each output on a single test vector, reusing a simulation context of the Aig for repeated calls
+	 */
+	std::vector<bool> compute_output_value(SimContext &sim, const std::vector<bool> &inputs) const;
 
 	/**
 	 * @brief Returns whether the two bits are pairwise secure with the given test vectors
@@ -137,7 +167,12 @@ class LogicLockingAnalyzer
 	 * @param a, b Two signal bits to check
 	 * @param ignore_duplicates If true, signals with the same impact are not considered pairwise secure
 	 */
-	bool is_pairwise_secure(SigBit a, SigBit b, bool ignore_duplicates = true);
+	bool is_pairwise_secure(SigBit a, SigBit b, bool ignore_duplicates = true) const;
+
+	/**
+	 * @brief Returns whether the two bits are pairwise secure, reusing a simulation context of the Aig for repeated calls
+	 */
+	bool is_pairwise_secure(SimContext &sim, SigBit a, SigBit b, bool ignore_duplicates = true) const;
 
 	/**
 	 * @brief Returns the list of pairwise-secure signal pairs
@@ -192,14 +227,14 @@ class LogicLockingAnalyzer
 	std::vector<Cell *> get_lockable_cells() const;
 
 	/**
-	 * @brief Simulate on a bitset of test vectors and return the module's outputs
+	 * @brief Simulate on a bitset of test vectors and return the module's outputs, cell by cell (for checking)
 	 */
-	std::vector<std::uint64_t> simulate_basic(int tv, const pool<SigBit> &toggled_bits);
+	std::vector<std::uint64_t> simulate_basic(int tv, const pool<SigBit> &toggled_bits) const;
 
 	/**
-	 * @brief Simulate on a bitset of test vectors and return the module's outputs
+	 * @brief Simulate on a bitset of test vectors and return the module's outputs, using the buffers of this context
 	 */
-	std::vector<std::uint64_t> simulate_aig(int tv, const pool<SigBit> &toggled_bits);
+	std::vector<std::uint64_t> simulate_aig(SimContext &sim, int tv, const pool<SigBit> &toggled_bits) const;
 
 	/**
 	 * @brief Create the output corruption analysis
@@ -231,6 +266,11 @@ class LogicLockingAnalyzer
 	 */
 	std::vector<double> compute_KIP(const std::vector<Cell *> &cells);
 
+	/**
+	 * @brief Compute the COP observability of each cell: the probability that locking it changes an output, computed analytically
+	 */
+	std::vector<double> compute_cop_observability(const std::vector<Cell *> &cells) const;
+
 	/**
 	 * @brief Set the specified inputs to be the given constants on all test vectors
 	 *
@@ -238,36 +278,103 @@ class LogicLockingAnalyzer
 	 */
 	void set_input_values(const std::vector<SigBit> &inputs, const std::vector<bool> &values);
 
+	/**
+	 * @brief Set the specified input to the given values, one per test vector
+	 */
+	void set_input_values(SigBit input, const std::vector<std::uint64_t> &values);
+
+	/**
+	 * @brief Obtain the input values of a single pattern, given by its test vector and its position in the test vector
+	 */
+	std::vector<bool> get_test_pattern(int tv, int lane) const;
+
 	/**
 	 * @brief Direct access to the internal Aig
 	 */
-	const MiniAIG &aig() const { return aig_; }
+	const MiniAIG &aig() const { return *aig_; }
+
+	/**
+	 * @brief Write the internal Aig in binary Aiger format, with the names of the inputs and outputs,
+	 * and the lockable signals as toggle points
+	 */
+	void write_aiger(std::ostream &f) const;
+
+	/**
+	 * @brief Literal of the internal Aig corresponding to a design signal
+	 */
+	Lit get_aig_literal(SigBit bit) const;
+
+	/**
+	 * @brief Reduce the internal Aig by merging equivalent and constant nodes (SAT sweeping), then renumber it in depth-first order
+	 *
+	 * @param keep_signals If true, the nodes of the lockable signals are kept distinct so that they can still be toggled
+	 */
+	void sweep_aig(bool keep_signals = true);
 
       private:
 	/**
-	 * @brief Create wire to consuming cells information
+	 * @brief Assign a dense index to each signal bit of the module, merging aliases
 	 */
-	void init_wire_to_cells();
+	void init_signal_ids();
 
 	/**
-	 * @brief Create wire to connected wires (aliases) information
+	 * @brief Dense index of a signal bit; constants are indexed by their value
 	 */
-	void init_wire_to_wires();
+	int get_signal_id(SigBit bit) const;
 
-	void set_input_state(const dict<SigBit, State> &state);
+	/**
+	 * @brief Whether a signal bit has been converted to the Aig
+	 */
+	bool has_aig_literal(SigBit bit) const { return id_in_aig_[get_signal_id(bit)]; }
 
-	dict<SigBit, State> get_output_state() const;
+	/**
+	 * @brief Discard the data computed from the test vectors, after they are modified
+	 */
+	void reset_test_vector_data();
+
+	/**
+	 * @brief Position of a combinatorial input in the test vectors
+	 */
+	int get_input_index(SigBit input) const;
 
-	bool has_state(SigSpec b);
+	/// @brief State of the cell-by-cell simulation
+	struct CellSimState {
+		/// Current state of each signal index (State::Sm if not computed yet)
+		std::vector<State> state;
+		/// Whether each signal index is subject to toggling
+		std::vector<char> toggled;
+	};
 
-	Const get_state(SigSpec b);
+	bool has_state(const CellSimState &sim, SigSpec b) const;
 
-	void set_state(SigSpec b, Const val);
+	Const get_state(const CellSimState &sim, SigSpec b) const;
 
-	void simulate_cell(Cell *cell);
+	void set_state(CellSimState &sim, SigSpec b, Const val) const;
 
+	void simulate_cell(CellSimState &sim, Cell *cell) const;
+
+	/**
+	 * @brief Compute a topological order of the cells, from the inputs and constants
+	 *
+	 * Cells in combinatorial loops, or that depend on them, do not appear in the order.
+	 */
+	std::vector<Cell *> compute_conversion_order() const;
+
+	/**
+	 * @brief Build the Aig in a single pass over the cells in topological order
+	 */
 	void init_aig();
 
+	/**
+	 * @brief Load the Aig from the persistent cache instead of building it
+	 */
+	bool load_aig(const std::string &path, std::uint64_t hash);
+
+	/**
+	 * @brief Pairwise secure signals among the lockable signals, given by their indices
+	 */
+	const std::vector<std::pair<int, int>> &compute_pairwise_secure_indices(bool ignore_duplicates);
+
 	/**
 	 * @brief Report potential issues when converting to AIG
 	 */
@@ -289,29 +396,43 @@ class LogicLockingAnalyzer
 	/// @brief Test vectors used for analysis
 	std::vector<std::vector<std::uint64_t>> test_vectors_;
 
-	/// @brief Map a wire to the cells it inputs into
-	dict<SigBit, pool<Cell *>> wire_to_cells_;
+	/// @brief Results computed from the current test vectors for the lockable signals
+	struct TestVectorData {
+		/// Corruption data of each signal; empty if not computed yet
+		std::vector<std::vector<std::vector<std::uint64_t>>> corruption;
+		/// Pairwise secure signals, without and with duplicates ignored
+		std::vector<std::pair<int, int>> pairwise[2];
+		/// Whether the pairwise secure signals are computed, without and with duplicates ignored
+		bool has_pairwise[2] = {false, false};
+		/// Canonical hash of the module, if persisted
+		std::uint64_t cache_hash = 0;
+		/// Name of the test vector configuration in the persistent cache; empty if not persisted
+		std::string cache_name;
+	};
+
+	/// @brief Results computed from the current test vectors, shared between copies
+	std::shared_ptr<TestVectorData> test_vector_data_;
 
-	/// @brief Map a wire to other wires it feeds
-	dict<SigBit, pool<SigBit>> wire_to_wires_;
+	/// @brief Dense index of each wire bit; directly connected bits share the same index
+	dict<SigBit, int> bit_to_id_;
 
-	/// @brief Map a wire back to its driver cell
-	dict<SigBit, Cell *> wire_to_driver_;
+	/// @brief Number of signal indices, including the constants
+	int nb_signals_;
 
-	/// @brief Wires that need to be examined during traversal
-	pool<SigBit> dirty_bits_;
+	/// @brief Cells in topological order, as used for the conversion
+	std::vector<Cell *> cell_order_;
 
-	/// @brief AIG representation of the circuit
-	MiniAIG aig_;
+	/// @brief Driver cell of each signal index, or nullptr
+	std::vector<Cell *> id_to_driver_;
 
-	/// @brief Mapping between design wires and AIG literals
-	dict<SigBit, Lit> wire_to_aig_;
+	/// @brief AIG representation of the circuit, shared between copies; never modified once built
+	std::shared_ptr<MiniAIG> aig_;
 
-	/// @brief During bit simulation, current state of the wires
-	dict<SigBit, State> state_;
+	/// @brief Mapping between signal indices and AIG literals
+	std::vector<Lit> id_to_aig_;
 
-	/// @brief During bit simulation, current set of wires that are subject to toggling
-	pool<SigBit> toggled_bits_;
+	/// @brief Whether each signal index has an AIG literal
+	std::vector<char> id_in_aig_;
 };
 
 #endif
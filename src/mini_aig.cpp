@@ -4,6 +4,7 @@
 
 #include "mini_aig.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 std::ostream &operator<<(std::ostream &s, Lit l)
@@ -16,46 +17,74 @@ std::ostream &operator<<(std::ostream &s, Lit l)
 	return s;
 }
 
-std::vector<std::uint64_t> MiniAIG::simulate(const std::vector<std::uint64_t> &inputVals)
+SimContext::SimContext(const MiniAIG &aig) : aig_(&aig), state_(aig.nbVars(), 0), laneMasks_(aig.nbVars(), 0), isTouched_(aig.nbVars(), false)
 {
-	assert(inputVals.size() == (std::size_t)nbInputs_);
+}
+
+std::vector<std::uint64_t> SimContext::simulate(const std::vector<std::uint64_t> &inputVals)
+{
+	const MiniAIG &aig = *aig_;
+	assert(inputVals.size() == aig.nbInputs_);
 	state_[0] = 0; // Constant value
-	for (std::size_t i = 0; i < nbInputs_; ++i) {
+	for (std::size_t i = 0; i < aig.nbInputs_; ++i) {
 		state_[i + 1] = inputVals[i];
 	}
-	for (std::size_t i = 0; i < nodes_.size(); ++i) {
-		state_[i + nbInputs_ + 1] = getValue(nodes_[i].a) & getValue(nodes_[i].b);
+	for (std::size_t i = 0; i < aig.nodes_.size(); ++i) {
+		state_[i + aig.nbInputs_ + 1] = getValue(aig.nodes_[i].a) & getValue(aig.nodes_[i].b);
 	}
 	return getOutputValues();
 }
 
-std::vector<std::uint64_t> MiniAIG::simulateWithToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling)
+std::vector<std::uint64_t> SimContext::simulateWithToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling)
 {
-	check();
-	std::vector<std::uint8_t> toggles(nbInputs_ + state_.size() + 1, 0);
+	const MiniAIG &aig = *aig_;
+	std::vector<std::uint8_t> toggles(state_.size(), 0);
 	for (Lit t : toggling) {
 		// Forbid toggling on constants, or toggling the same variable twice
 		assert(!t.is_constant());
 		assert(!toggles[t.variable()]);
 		toggles[t.variable()] = 1;
 	}
-	assert(inputVals.size() == (std::size_t)nbInputs_);
-	for (std::size_t i = 0; i < nbInputs_; ++i) {
+	assert(inputVals.size() == aig.nbInputs_);
+	state_[0] = 0;
+	for (std::size_t i = 0; i < aig.nbInputs_; ++i) {
 		std::uint64_t t = toggles[i + 1];
 		t = ~t + 1;
 		assert(t == 0 || t == (std::uint64_t)-1);
 		state_[i + 1] = t ^ inputVals[i];
 	}
-	for (std::size_t i = 0; i < nodes_.size(); ++i) {
-		std::uint64_t t = toggles[i + nbInputs_ + 1];
+	for (std::size_t i = 0; i < aig.nodes_.size(); ++i) {
+		std::uint64_t t = toggles[i + aig.nbInputs_ + 1];
 		t = ~t + 1;
 		assert(t == 0 || t == (std::uint64_t)-1);
-		state_[i + nbInputs_ + 1] = t ^ (getValue(nodes_[i].a) & getValue(nodes_[i].b));
+		state_[i + aig.nbInputs_ + 1] = t ^ (getValue(aig.nodes_[i].a) & getValue(aig.nodes_[i].b));
 	}
 	return getOutputValues();
 }
 
-void MiniAIG::resetIncrementalState()
+std::vector<std::uint64_t> SimContext::simulateWithLaneToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling)
+{
+	const MiniAIG &aig = *aig_;
+	assert(toggling.size() <= 64);
+	assert(inputVals.size() == aig.nbInputs_);
+	for (std::size_t lane = 0; lane < toggling.size(); ++lane) {
+		laneMasks_[toggling[lane].variable()] |= (std::uint64_t)1 << lane;
+	}
+	state_[0] = laneMasks_[0];
+	for (std::size_t i = 0; i < aig.nbInputs_; ++i) {
+		state_[i + 1] = laneMasks_[i + 1] ^ inputVals[i];
+	}
+	for (std::size_t i = 0; i < aig.nodes_.size(); ++i) {
+		std::size_t v = i + aig.nbInputs_ + 1;
+		state_[v] = laneMasks_[v] ^ (getValue(aig.nodes_[i].a) & getValue(aig.nodes_[i].b));
+	}
+	for (Lit t : toggling) {
+		laneMasks_[t.variable()] = 0;
+	}
+	return getOutputValues();
+}
+
+void SimContext::resetIncrementalState()
 {
 	assert(toVisit_.empty());
 	for (std::uint32_t i : touchedVars_) {
@@ -65,7 +94,7 @@ void MiniAIG::resetIncrementalState()
 	touchedVars_.clear();
 }
 
-void MiniAIG::updateState(std::uint32_t i, std::uint64_t value)
+void SimContext::updateState(std::uint32_t i, std::uint64_t value)
 {
 	if (!isTouched_[i]) {
 		isTouched_[i] = true;
@@ -75,34 +104,70 @@ void MiniAIG::updateState(std::uint32_t i, std::uint64_t value)
 		return;
 	}
 	state_[i] = value;
-	for (std::uint32_t n : fanouts_[i]) {
+	const std::vector<std::uint32_t> &fanouts = aig_->fanouts_[i];
+	if (hasSimStats) {
+		++simStats_.nbChanged;
+		simStats_.bytesTouched += sizeof(std::uint64_t) + fanouts.size() * (sizeof(std::uint32_t) + sizeof(char));
+	}
+	for (std::uint32_t n : fanouts) {
 		if (!isTouched_[n]) {
 			isTouched_[n] = true;
 			touchedVars_.push_back(n);
 			toVisit_.push(n);
+			if (hasSimStats) {
+				++simStats_.nbHeapOps;
+			}
 		}
 	}
 }
 
-std::vector<std::uint64_t> MiniAIG::simulateIncremental(Lit toggling)
+std::vector<std::uint64_t> SimContext::simulateIncremental(Lit toggling)
 {
+	assert(aig_->fanouts_.size() == state_.size());
+	if (hasSimStats) {
+		++simStats_.nbToggles;
+	}
 	updateState(toggling.variable(), ~state_[toggling.variable()]);
+	return propagateIncremental();
+}
+
+std::vector<std::uint64_t> SimContext::simulateIncremental(const std::vector<Lit> &togglings)
+{
+	assert(aig_->fanouts_.size() == state_.size());
+	for (Lit toggling : togglings) {
+		if (hasSimStats) {
+			++simStats_.nbToggles;
+		}
+		assert(!isTouched_[toggling.variable()]);
+		updateState(toggling.variable(), ~state_[toggling.variable()]);
+	}
+	return propagateIncremental();
+}
+
+std::vector<std::uint64_t> SimContext::propagateIncremental()
+{
+	const MiniAIG &aig = *aig_;
 	while (!toVisit_.empty()) {
 		std::uint32_t i = toVisit_.top();
-		std::uint32_t node = i - nbInputs_ - 1;
-		assert(node < nodes_.size());
+		std::uint32_t node = i - aig.nbInputs_ - 1;
+		assert(node < aig.nodes_.size());
 		toVisit_.pop();
-		updateState(i, getValue(nodes_[node].a) & getValue(nodes_[node].b));
+		if (hasSimStats) {
+			++simStats_.nbHeapOps;
+			++simStats_.nbEvaluated;
+			simStats_.bytesTouched += sizeof(MiniAIG::AIGNode) + 2 * sizeof(std::uint64_t);
+		}
+		updateState(i, getValue(aig.nodes_[node].a) & getValue(aig.nodes_[node].b));
 	}
 	auto ret = getOutputValues();
 	resetIncrementalState();
 	return ret;
 }
 
-std::vector<std::uint64_t> MiniAIG::getOutputValues() const
+std::vector<std::uint64_t> SimContext::getOutputValues() const
 {
 	std::vector<std::uint64_t> ret;
-	for (Lit l : outputs_) {
+	for (Lit l : aig_->outputs_) {
 		ret.push_back(getValue(l));
 	}
 	return ret;
@@ -110,13 +175,11 @@ std::vector<std::uint64_t> MiniAIG::getOutputValues() const
 
 void MiniAIG::check() const
 {
-	assert(state_.size() == nodes_.size() + nbInputs_ + 1);
-	assert(state_[0] == 0);
-	assert(fanouts_.size() == state_.size());
-	assert(isTouched_.size() == state_.size());
+	[[maybe_unused]] std::size_t nbVars = this->nbVars();
+	assert(fanouts_.empty() || fanouts_.size() == nbVars);
 	for ([[maybe_unused]] AIGNode n : nodes_) {
-		assert(n.a.variable() < state_.size());
-		assert(n.b.variable() < state_.size());
+		assert(n.a.variable() < nbVars);
+		assert(n.b.variable() < nbVars);
 	}
 	// Topological sort
 	for (std::size_t i = 0; i < nodes_.size(); ++i) {
@@ -124,9 +187,9 @@ void MiniAIG::check() const
 		assert(nodes_[i].b.variable() < i + nbInputs_ + 1);
 	}
 	// Topological sort for node fanouts
-	for (std::size_t i = 0; i < state_.size(); ++i) {
+	for (std::size_t i = 0; i < fanouts_.size(); ++i) {
 		for (std::uint32_t n : fanouts_[i]) {
-			assert(n < state_.size());
+			assert(n < nbVars);
 			assert(n >= nbInputs_ + 1);
 			assert(n > i);
 		}
@@ -136,14 +199,90 @@ void MiniAIG::check() const
 void MiniAIG::setupIncremental()
 {
 	fanouts_.clear();
-	fanouts_.resize(nbInputs_ + nodes_.size() + 1);
-	isTouched_.resize(nbInputs_ + nodes_.size() + 1, false);
+	fanouts_.resize(nbVars());
 	for (std::size_t node = 0; node < nodes_.size(); ++node) {
 		std::uint32_t i = node + nbInputs_ + 1;
 		fanouts_[nodes_[node].a.data >> 1].push_back(i);
 		fanouts_[nodes_[node].b.data >> 1].push_back(i);
 	}
-	touchedVars_.clear();
+}
+
+int MiniAIG::fanoutConeSize(Lit lit) const
+{
+	std::size_t var = lit.variable();
+	if (var == 0) {
+		return 0;
+	}
+	std::size_t nbVars = this->nbVars();
+	std::vector<char> inCone(nbVars - var, 0);
+	inCone[0] = 1;
+	int ret = 1;
+	for (std::size_t i = std::max(var + 1, nbInputs_ + 1); i < nbVars; ++i) {
+		const AIGNode &n = nodes_[i - nbInputs_ - 1];
+		std::size_t a = n.a.variable();
+		std::size_t b = n.b.variable();
+		if ((a >= var && inCone[a - var]) || (b >= var && inCone[b - var])) {
+			inCone[i - var] = 1;
+			++ret;
+		}
+	}
+	return ret;
+}
+
+std::vector<Lit> MiniAIG::renumberDfs()
+{
+	std::size_t nbVars = this->nbVars();
+	std::vector<Lit> mapping(nbVars);
+	std::vector<char> placed(nbVars, false);
+	for (std::size_t v = 0; v <= nbInputs_; ++v) {
+		mapping[v] = Lit(v << 1);
+		placed[v] = true;
+	}
+	auto mapLit = [&](Lit l) { return l.polarity() ? mapping[l.variable()].inv() : mapping[l.variable()]; };
+	std::vector<AIGNode> newNodes;
+	newNodes.reserve(nodes_.size());
+	std::vector<std::uint32_t> stack;
+	auto visit = [&](std::uint32_t root) {
+		stack.push_back(root);
+		while (!stack.empty()) {
+			std::uint32_t v = stack.back();
+			if (placed[v]) {
+				stack.pop_back();
+				continue;
+			}
+			const AIGNode &n = nodes_[v - nbInputs_ - 1];
+			std::uint32_t a = n.a.variable();
+			std::uint32_t b = n.b.variable();
+			if (!placed[a] || !placed[b]) {
+				// Visit the first fanin first
+				if (!placed[b]) {
+					stack.push_back(b);
+				}
+				if (!placed[a]) {
+					stack.push_back(a);
+				}
+				continue;
+			}
+			mapping[v] = Lit((std::uint32_t)(newNodes.size() + nbInputs_ + 1) << 1);
+			newNodes.emplace_back(mapLit(n.a), mapLit(n.b));
+			placed[v] = true;
+			stack.pop_back();
+		}
+	};
+	for (Lit o : outputs_) {
+		visit(o.variable());
+	}
+	for (std::size_t v = nbInputs_ + 1; v < nbVars; ++v) {
+		visit(v);
+	}
+	nodes_ = newNodes;
+	for (Lit &o : outputs_) {
+		o = mapLit(o);
+	}
+	if (!fanouts_.empty()) {
+		setupIncremental();
+	}
+	return mapping;
 }
 
 void MiniAIG::print() const
@@ -28,21 +28,45 @@ struct Lit {
 	static Lit one() { return Lit(1); }
 	bool is_constant() const { return variable() == 0; }
 
+	/// Raw encoding of the literal, twice the variable number plus the polarity (as in the Aiger format)
+	std::uint32_t raw() const { return data; }
+	static Lit fromRaw(std::uint32_t d) { return Lit(d); }
+
       private:
 	std::uint32_t data;
 	explicit Lit(std::uint32_t a) : data(a) {}
 	friend class MiniAIG;
 };
 
+/**
+ * @brief Counters of the incremental simulation
+ *
+ * They are only updated when compiled with MOOSIC_SIM_STATS (make ENABLE_SIM_STATS=1), and stay zero otherwise.
+ */
+struct IncrementalSimStats {
+	/// Number of incremental simulations
+	std::uint64_t nbToggles = 0;
+	/// Number of nodes evaluated
+	std::uint64_t nbEvaluated = 0;
+	/// Number of nodes whose value changed, including the toggled one
+	std::uint64_t nbChanged = 0;
+	/// Number of insertions and removals in the queue of nodes to visit
+	std::uint64_t nbHeapOps = 0;
+	/// Estimated number of bytes of node, state and fanout data read or written
+	std::uint64_t bytesTouched = 0;
+};
+
 /**
  * @brief A very basic AIG class for simulation
  *
- * The circuit is represented as a network of and gates with inverters
+ * The circuit is represented as a network of and gates with inverters.
+ * Once built, the graph is not modified by simulation: any number of SimContext objects may
+ * simulate the same MiniAIG concurrently.
  */
 class MiniAIG
 {
       public:
-	explicit MiniAIG(int nbInputs = 0) : nbInputs_(nbInputs), state_(nbInputs_ + 1) {}
+	explicit MiniAIG(int nbInputs = 0) : nbInputs_(nbInputs) {}
 
 	/**
 	 * Query the number of inputs
@@ -59,6 +83,11 @@ class MiniAIG
 	 */
 	int nbNodes() const { return nodes_.size(); }
 
+	/**
+	 * Query the number of variables (constant, inputs and nodes)
+	 */
+	int nbVars() const { return nbInputs_ + nodes_.size() + 1; }
+
 	/**
 	 * Get the literal corresponding to an input
 	 */
@@ -91,7 +120,6 @@ class MiniAIG
 	{
 		std::uint32_t d = nodes_.size() + nbInputs_ + 1;
 		nodes_.emplace_back(a, b);
-		state_.emplace_back();
 		return Lit(d << 1);
 	}
 
@@ -117,13 +145,76 @@ class MiniAIG
 	 */
 	Lit addNot(Lit a) { return addAnd(a, a); }
 
+	/**
+	 * Check the datastructure
+	 */
+	void check() const;
+
+	/**
+	 * Setup the datastructures for incremental simulation, once the graph is complete
+	 */
+	void setupIncremental();
+
+	/**
+	 * Nodes using a variable, for incremental simulation
+	 */
+	const std::vector<std::uint32_t> &fanouts(std::uint32_t var) const { return fanouts_[var]; }
+
+	/**
+	 * Number of nodes in the transitive fanout of a literal, including its own node
+	 */
+	int fanoutConeSize(Lit lit) const;
+
+	/**
+	 * Renumber the nodes in depth-first order from the outputs, so that the logic of each output is contiguous in memory
+	 *
+	 * Nodes that do not reach an output are kept, after the others. Returns the new literal of each previous variable.
+	 */
+	std::vector<Lit> renumberDfs();
+
+	/**
+	 * Print the network for debugging
+	 */
+	void print() const;
+
+      private:
+	struct AIGNode {
+		Lit a;
+		Lit b;
+		AIGNode(Lit x, Lit y) : a(x), b(y) {}
+	};
+	std::vector<AIGNode> nodes_;
+	std::vector<Lit> outputs_;
+	std::size_t nbInputs_;
+
+	/// Fanout of each node for incremental simulation
+	std::vector<std::vector<std::uint32_t>> fanouts_;
+
+	friend class SimContext;
+};
+
+/**
+ * @brief Simulation state of a MiniAIG, with all the buffers of a simulation run
+ *
+ * Each thread uses its own context; the Aig must outlive the context and not be modified while it is used.
+ */
+class SimContext
+{
+      public:
+	explicit SimContext(const MiniAIG &aig);
+
+	/**
+	 * The simulated Aig
+	 */
+	const MiniAIG &aig() const { return *aig_; }
+
 	/**
 	 * Query the value of a literal in the current simulation
 	 */
 	std::uint64_t getValue(Lit a) const
 	{
-		std::uint64_t s = state_[a.data >> 1];
-		std::uint64_t toggle = a.data & 1;
+		std::uint64_t s = state_[a.variable()];
+		std::uint64_t toggle = a.polarity();
 		toggle = ~toggle + 1;
 		assert(toggle == 0 || toggle == (std::uint64_t)-1);
 		return s ^ toggle;
@@ -132,22 +223,34 @@ class MiniAIG
 	/**
 	 * Set the value of a literal in the current simulation
 	 */
-	void setValue(Lit a, std::uint64_t val) { state_[a.data >> 1] = a.polarity() ? ~val : val; }
+	void setValue(Lit a, std::uint64_t val) { state_[a.variable()] = a.polarity() ? ~val : val; }
 
 	/**
 	 * Get the whole internal state
 	 */
-	std::vector<std::uint64_t> getState() const { return state_; }
+	const std::vector<std::uint64_t> &getState() const { return state_; }
 
 	/**
-	 * Check the datastructure
+	 * Query the values of the outputs in the current simulation
 	 */
-	void check() const;
+	std::vector<std::uint64_t> getOutputValues() const;
 
 	/**
-	 * Setup the datastructures for incremental simulation
+	 * Simulate the network on these inputs
 	 */
-	void setupIncremental();
+	std::vector<std::uint64_t> simulate(const std::vector<std::uint64_t> &inputVals);
+
+	/**
+	 * Simulate the network on these inputs, with some nodes toggled to simulate logic locking
+	 */
+	std::vector<std::uint64_t> simulateWithToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling);
+
+	/**
+	 * Simulate the network with the i-th toggled literal inverted in lane (bit) i only, for at most 64 togglings
+	 *
+	 * With the same pattern in all lanes, each lane gives the outputs for one toggling.
+	 */
+	std::vector<std::uint64_t> simulateWithLaneToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling);
 
 	/**
 	 * Copy the state of the simulation before an incremental run
@@ -155,60 +258,69 @@ class MiniAIG
 	void copyIncrementalState() { savedState_ = state_; }
 
 	/**
-	 * Reset the state for incremental simulation
+	 * Simulate the network with a single toggling using the previous state
 	 */
-	void resetIncrementalState();
+	std::vector<std::uint64_t> simulateIncremental(Lit toggling);
 
 	/**
-	 * Update a node for incremental simulation
+	 * Simulate the network with several togglings at once using the previous state
+	 *
+	 * No toggled variable may be in the transitive fanout of another one, so that each toggling is
+	 * applied exactly once.
 	 */
-	void updateState(std::uint32_t i, std::uint64_t value);
+	std::vector<std::uint64_t> simulateIncremental(const std::vector<Lit> &togglings);
 
 	/**
-	 * Query the values of the outputs in the current simulation
+	 * Whether the incremental simulation counters are compiled in
 	 */
-	std::vector<std::uint64_t> getOutputValues() const;
+	static constexpr bool hasSimStats =
+#ifdef MOOSIC_SIM_STATS
+		true;
+#else
+		false;
+#endif
 
 	/**
-	 * Simulate the network on these inputs
+	 * Counters of the incremental simulation since the last reset
 	 */
-	std::vector<std::uint64_t> simulate(const std::vector<std::uint64_t> &inputVals);
+	const IncrementalSimStats &simStats() const { return simStats_; }
 
 	/**
-	 * Simulate the network on these inputs, with some nodes toggled to simulate logic locking
+	 * Reset the counters of the incremental simulation
 	 */
-	std::vector<std::uint64_t> simulateWithToggling(const std::vector<std::uint64_t> &inputVals, const std::vector<Lit> &toggling);
+	void resetSimStats() { simStats_ = IncrementalSimStats(); }
 
+      private:
 	/**
-	 * Simulate the network with a single toggling using the previous state
+	 * Reset the state for incremental simulation
 	 */
-	std::vector<std::uint64_t> simulateIncremental(Lit toggling);
+	void resetIncrementalState();
 
 	/**
-	 * Print the network for debugging
+	 * Update a node for incremental simulation
 	 */
-	void print() const;
+	void updateState(std::uint32_t i, std::uint64_t value);
+
+	/**
+	 * Propagate the toggled nodes in topological order, then return the outputs and restore the previous state
+	 */
+	std::vector<std::uint64_t> propagateIncremental();
 
       private:
-	struct AIGNode {
-		Lit a;
-		Lit b;
-		AIGNode(Lit x, Lit y) : a(x), b(y) {}
-	};
-	std::vector<AIGNode> nodes_;
-	std::vector<Lit> outputs_;
-	std::size_t nbInputs_;
+	const MiniAIG *aig_;
 	std::vector<std::uint64_t> state_;
 	std::vector<std::uint64_t> savedState_;
 
+	/// Lanes toggled for each variable during lane toggling, zero otherwise
+	std::vector<std::uint64_t> laneMasks_;
 	/// List of nodes modified during this incremental simulation
 	std::vector<std::uint32_t> touchedVars_;
 	/// Whether a node is modified during this incremental simulation
 	std::vector<char> isTouched_;
-	/// Fanout of each node for incremental simulation
-	std::vector<std::vector<std::uint32_t>> fanouts_;
 	/// Nodes left to visit during incremental simulation
 	std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, std::greater<std::uint32_t>> toVisit_;
+	/// Counters of the incremental simulation, if enabled
+	IncrementalSimStats simStats_;
 };
 
 #endif
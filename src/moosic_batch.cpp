@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+/**
+ * @brief Standalone driver for the Yosys-independent core
+ *
+ * Runs the corruption analysis, the greedy selection and the Pareto exploration on an Aiger file,
+ * as written by ll_write_aiger, so that these steps can be profiled outside of Yosys.
+ */
+
+#include "aiger.hpp"
+#include "corruption_analysis.hpp"
+#include "optimization_moves.hpp"
+#include "output_corruption_optimizer.hpp"
+#include "phase_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+void usage()
+{
+	std::cout << "Usage: moosic_batch <file.aig> [options]\n"
+		  << "\n"
+		  << "Run the logic locking analyses on an Aig; the toggle points of the file are the candidates\n"
+		  << "for locking, or all and gates if there are none.\n"
+		  << "\n"
+		  << "    -nb-test-vectors <value>\n"
+		  << "        number of random test vectors (64 patterns each) used for analysis (default=16)\n"
+		  << "    -seed <value>\n"
+		  << "        seed for the test vectors (default=1)\n"
+		  << "    -nb-locked <value>\n"
+		  << "        number of signals selected by the greedy algorithm (default=5% of the candidates)\n"
+		  << "    -iter-limit <value>\n"
+		  << "        number of iterations of the Pareto exploration on size and corruptibility (default=10000)\n"
+		  << "    -trace <file>\n"
+		  << "        record the phases in Chrome trace format (also enabled by the MOOSIC_TRACE environment variable)\n";
+}
+
+/**
+ * @brief Time the phases of the run
+ */
+class PhaseTimer
+{
+      public:
+	PhaseTimer() : start_(std::chrono::steady_clock::now()) {}
+
+	void report(const std::string &phase)
+	{
+		auto now = std::chrono::steady_clock::now();
+		std::cout << "  " << phase << ": " << std::chrono::duration<double>(now - start_).count() << "s" << std::endl;
+		start_ = now;
+	}
+
+      private:
+	std::chrono::steady_clock::time_point start_;
+};
+
+int parseInt(const std::string &arg, const std::string &value)
+{
+	try {
+		return std::stoi(value);
+	} catch (const std::exception &) {
+		throw std::runtime_error("Invalid value for " + arg + ": " + value);
+	}
+}
+
+/**
+ * @brief Pareto exploration with the same local moves as ll_explore, maximizing corruptibility and minimizing size
+ */
+std::vector<std::pair<std::vector<int>, std::vector<double>>> explorePareto(const OutputCorruptionOptimizer &opt, long long iterLimit)
+{
+	std::mt19937 rgen(1);
+	std::vector<std::unique_ptr<OptimizationMove>> moves;
+	moves.emplace_back(new MoveInsert());
+	moves.emplace_back(new MoveDelete());
+	moves.emplace_back(new MoveSwap());
+
+	std::vector<std::pair<std::vector<int>, std::vector<double>>> front;
+	auto tryAdd = [&](std::vector<int> sol) {
+		if (sol.empty()) {
+			return;
+		}
+		std::sort(sol.begin(), sol.end());
+		std::vector<double> obj = {100.0 * opt.corruptibility(sol), -(double)sol.size()};
+		for (const auto &p : front) {
+			if (paretoDominates(p.second, obj)) {
+				return;
+			}
+		}
+		front.erase(std::remove_if(front.begin(), front.end(), [&](const auto &p) { return paretoDominates(obj, p.second); }),
+			    front.end());
+		front.emplace_back(sol, obj);
+	};
+
+	// Start from the greedy solutions
+	std::vector<int> greedy = opt.solveGreedy(opt.nbNodes());
+	for (std::size_t i = 1; i <= greedy.size(); ++i) {
+		tryAdd(std::vector<int>(greedy.begin(), greedy.begin() + i));
+	}
+	std::uniform_int_distribution<std::size_t> moveDist(0, moves.size() - 1);
+	for (long long iter = 0; iter < iterLimit; ++iter) {
+		std::vector<std::vector<int>> pool;
+		for (const auto &p : front) {
+			pool.push_back(p.first);
+		}
+		tryAdd(moves[moveDist(rgen)]->createSolution(opt.nbNodes(), pool, rgen));
+	}
+	std::sort(front.begin(), front.end(), [](const auto &a, const auto &b) { return a.second < b.second; });
+	return front;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "-help") {
+		usage();
+		return argc < 2 ? 1 : 0;
+	}
+	std::string filename = argv[1];
+	int nbTestVectors = 16;
+	int seed = 1;
+	int nbLocked = -1;
+	long long iterLimit = 10000;
+	std::string traceFile;
+
+	try {
+		for (int i = 2; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (i + 1 >= argc) {
+				throw std::runtime_error("Missing value for option " + arg);
+			}
+			std::string value = argv[++i];
+			if (arg == "-nb-test-vectors") {
+				nbTestVectors = parseInt(arg, value);
+			} else if (arg == "-seed") {
+				seed = parseInt(arg, value);
+			} else if (arg == "-nb-locked") {
+				nbLocked = parseInt(arg, value);
+			} else if (arg == "-iter-limit") {
+				iterLimit = parseInt(arg, value);
+			} else if (arg == "-trace") {
+				traceFile = value;
+			} else {
+				throw std::runtime_error("Unknown option " + arg);
+			}
+		}
+
+		TraceSession traceSession("moosic_batch", traceFile);
+		PhaseTimer timer;
+		std::cout << "Phases:" << std::endl;
+		std::ifstream f(filename, std::ios::binary);
+		if (!f) {
+			throw std::runtime_error("Could not open file " + filename);
+		}
+		AigerSymbols symbols;
+		MiniAIG aig = readAiger(f, symbols);
+		// Keep the logic of each output contiguous in memory for the incremental simulation
+		std::vector<Lit> order = aig.renumberDfs();
+		timer.report("read");
+
+		std::vector<Lit> toggles;
+		for (const auto &t : symbols.togglePoints) {
+			if (!t.second.is_constant()) {
+				Lit l = order[t.second.variable()];
+				toggles.push_back(t.second.polarity() ? l.inv() : l);
+			}
+		}
+		if (toggles.empty()) {
+			for (int i = 0; i < aig.nbNodes(); ++i) {
+				toggles.push_back(Lit::fromRaw(2 * (aig.nbInputs() + i + 1)));
+			}
+		}
+		auto testVectors = generateTestVectors(aig.nbInputs(), nbTestVectors, seed);
+		auto corruption = computeOutputCorruption(aig, testVectors, toggles);
+		timer.report("corruption analysis");
+
+		std::vector<OutputCorruptionOptimizer::CorruptionData> data;
+		for (const auto &c : corruption) {
+			OutputCorruptionOptimizer::CorruptionData flat;
+			for (const auto &o : c) {
+				flat.insert(flat.end(), o.begin(), o.end());
+			}
+			data.push_back(flat);
+		}
+		OutputCorruptionOptimizer opt(data);
+		if (nbLocked < 0) {
+			nbLocked = std::max(1, (int)toggles.size() / 20);
+		}
+		auto greedy = opt.solveGreedy(nbLocked);
+		timer.report("greedy selection");
+
+		auto front = explorePareto(opt, iterLimit);
+		timer.report("Pareto exploration");
+
+		std::cout << "Aig: " << aig.nbInputs() << " inputs, " << aig.nbOutputs() << " outputs, " << aig.nbNodes() << " and gates, "
+			  << toggles.size() << " candidates" << std::endl;
+		std::cout << "Greedy: " << greedy.size() << " signals locked, corruptibility " << 100.0 * opt.corruptibility(greedy) << "%"
+			  << std::endl;
+		std::cout << "Pareto front (size, corruptibility):" << std::endl;
+		for (const auto &p : front) {
+			std::cout << "  " << -p.second[1] << "\t" << p.second[0] << "%" << std::endl;
+		}
+	} catch (const std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
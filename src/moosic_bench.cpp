@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+/**
+ * @brief Microbenchmarks for the simulation and optimization kernels of the core library
+ *
+ * Each kernel runs on generated Aigs of controlled size, repeatedly until a minimum time is reached.
+ * Results are written as JSON on the standard output, with the throughput of each kernel and the
+ * peak memory of the process after it ran. The kernels that need a netlist (delay analysis, Sat
+ * attack) are benchmarked by the ll_bench pass, with the same rows.
+ */
+
+#include "benchmark.hpp"
+#include "corruption_analysis.hpp"
+#include "mini_aig.hpp"
+#include "output_corruption_optimizer.hpp"
+#include "pairwise_security_optimizer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+/// Number of test vectors (64 patterns each) used for the corruption benchmarks
+constexpr int nbBenchTestVectors = 4;
+
+/// Maximum number of toggled signals in the corruption benchmarks, to bound the memory of the corruption data
+constexpr int maxBenchToggles = 1000;
+
+/// Maximum number of nodes of the pairwise security graph in the clique benchmark
+constexpr int maxBenchGraphNodes = 20000;
+
+/**
+ * @brief Generate a random Aig; fanins are mostly picked among recent nodes, to obtain some depth
+ */
+MiniAIG generateAig(int nbInputs, int nbNodes, int nbOutputs, std::mt19937 &rgen)
+{
+	MiniAIG aig(nbInputs);
+	std::vector<Lit> lits;
+	for (int i = 0; i < nbInputs; ++i) {
+		lits.push_back(aig.getInput(i));
+	}
+	for (int i = 0; i < nbNodes; ++i) {
+		std::size_t window = std::min<std::size_t>(lits.size(), 64);
+		Lit a = lits[lits.size() - 1 - rgen() % window];
+		Lit b = lits[rgen() % lits.size()];
+		lits.push_back(aig.addAnd((rgen() & 1) ? a.inv() : a, (rgen() & 1) ? b.inv() : b));
+	}
+	for (int i = 0; i < nbOutputs; ++i) {
+		aig.addOutput(lits[lits.size() - 1 - rgen() % std::min<std::size_t>(lits.size(), 4 * nbOutputs)]);
+	}
+	aig.setupIncremental();
+	return aig;
+}
+
+/**
+ * @brief Report the progress on the standard error, the results being written on the standard output
+ */
+BenchResult logResult(const BenchResult &res)
+{
+	std::cerr << res.name << " (" << res.nbNodes << " nodes, " << res.nbCandidates << " candidates): " << res.throughput << " " << res.unit
+		  << std::endl;
+	return res;
+}
+
+std::vector<BenchResult> benchSize(int nbNodes, double minTime)
+{
+	std::vector<BenchResult> results;
+	std::mt19937 rgen(nbNodes);
+	int nbInputs = std::max(8, nbNodes / 50);
+	int nbOutputs = std::max(8, nbNodes / 100);
+	MiniAIG aig = generateAig(nbInputs, nbNodes, nbOutputs, rgen);
+	auto testVectors = generateTestVectors(nbInputs, nbBenchTestVectors, 1);
+	SimContext sim(aig);
+
+	results.push_back(logResult(runBench("simulate", nbNodes, nbNodes, "nodes/s", minTime, [&]() {
+		sim.simulate(testVectors[0]);
+		return (double)aig.nbNodes();
+	})));
+
+	std::vector<Lit> toggles;
+	for (int i = 0; i < std::min(nbNodes, maxBenchToggles); ++i) {
+		toggles.push_back(Lit::fromRaw(2 * (nbInputs + 1 + rgen() % nbNodes)));
+	}
+	sim.simulate(testVectors[0]);
+	sim.copyIncrementalState();
+	results.push_back(logResult(runBench("simulate_incremental", nbNodes, (int)toggles.size(), "toggles/s", minTime, [&]() {
+		for (Lit t : toggles) {
+			sim.simulateIncremental(t);
+		}
+		return (double)toggles.size();
+	})));
+
+	std::vector<std::vector<std::vector<std::uint64_t>>> corruption;
+	results.push_back(logResult(runBench("output_corruption", nbNodes, (int)toggles.size(), "signals/s", minTime, [&]() {
+		corruption = computeOutputCorruption(aig, testVectors, toggles);
+		return (double)toggles.size();
+	})));
+
+	std::vector<OutputCorruptionOptimizer::CorruptionData> data;
+	for (const auto &c : corruption) {
+		OutputCorruptionOptimizer::CorruptionData flat;
+		for (const auto &o : c) {
+			flat.insert(flat.end(), o.begin(), o.end());
+		}
+		data.push_back(flat);
+	}
+	OutputCorruptionOptimizer opt(data);
+	int nbLocked = std::max(1, opt.nbNodes() / 20);
+	results.push_back(logResult(runBench("greedy_corruption", nbNodes, opt.nbNodes(), "evaluations/s", minTime, [&]() {
+		opt.solveGreedy(nbLocked);
+		return (double)opt.nbNodes() * nbLocked;
+	})));
+
+	// Sparse random pairwise security graph, with an average degree of 8
+	int nbGraphNodes = std::min(nbNodes, maxBenchGraphNodes);
+	std::vector<std::vector<int>> graph(nbGraphNodes);
+	for (long long e = 0; e < 4LL * nbGraphNodes; ++e) {
+		int i = rgen() % nbGraphNodes;
+		int j = rgen() % nbGraphNodes;
+		graph[i].push_back(j);
+		graph[j].push_back(i);
+	}
+	results.push_back(logResult(runBench("bron_kerbosch", nbNodes, nbGraphNodes, "nodes/s", minTime, [&]() {
+		PairwiseSecurityOptimizer pairwise(graph);
+		return (double)pairwise.nbNodes();
+	})));
+	return results;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	std::vector<int> sizes = {1000, 10000, 100000};
+	double minTime = 0.5;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (i + 1 >= argc) {
+				throw std::runtime_error("Missing value for option " + arg);
+			}
+			std::string value = argv[++i];
+			if (arg == "-sizes") {
+				sizes.clear();
+				std::stringstream s(value);
+				std::string size;
+				while (std::getline(s, size, ',')) {
+					sizes.push_back(std::stoi(size));
+				}
+			} else if (arg == "-min-time") {
+				minTime = std::stod(value);
+			} else {
+				throw std::runtime_error("Unknown option " + arg);
+			}
+		}
+		std::vector<BenchResult> results;
+		for (int size : sizes) {
+			if (size <= 0) {
+				throw std::runtime_error("Benchmark sizes must be positive");
+			}
+			auto res = benchSize(size, minTime);
+			results.insert(results.end(), res.begin(), res.end());
+		}
+		writeBenchJson(std::cout, results);
+	} catch (const std::exception &e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		std::cerr << "Usage: moosic_bench [-sizes 1000,10000,100000] [-min-time 0.5]" << std::endl;
+		return 1;
+	}
+	return 0;
+}
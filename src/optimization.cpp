@@ -4,43 +4,7 @@
 
 #include "optimization.hpp"
 
-std::vector<int> LocalMove::createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen)
-{
-	std::uniform_int_distribution<size_t> dist(0, solutionPool.size());
-	size_t ind = dist(rgen);
-	const std::vector<int> sol = ind < solutionPool.size() ? solutionPool[ind] : std::vector<int>();
-	return modifySolution(nbNodes, sol, rgen);
-}
-
-std::vector<int> MoveInsert::modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen)
-{
-	std::uniform_int_distribution<int> dist(0, nbNodes - 1);
-	int added = dist(rgen);
-	if (std::find(solution.begin(), solution.end(), added) != solution.end()) {
-		return std::vector<int>();
-	}
-	std::vector<int> ret = solution;
-	ret.push_back(added);
-	return ret;
-}
-
-std::vector<int> MoveDelete::modifySolution(int, const std::vector<int> &solution, std::mt19937 &rgen)
-{
-	if (solution.empty()) {
-		return std::vector<int>();
-	}
-	std::uniform_int_distribution<size_t> dist(0, solution.size() - 1);
-	size_t deleted = dist(rgen);
-	std::vector<int> ret = solution;
-	ret.erase(ret.begin() + deleted);
-	return ret;
-}
-
-std::vector<int> MoveSwap::modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen)
-{
-	auto inserted = MoveInsert().modifySolution(nbNodes, solution, rgen);
-	return MoveDelete().modifySolution(nbNodes, inserted, rgen);
-}
+#include <algorithm>
 
 Optimizer::Optimizer(Module *module, const std::vector<Cell *> &cells, const std::vector<ObjectiveType> &objectives, int nbAnalysisVectors,
 		     int nbAnalysisKeys)
@@ -72,6 +36,22 @@ std::vector<std::vector<double>> Optimizer::paretoObjectives() const
 	return ret;
 }
 
+int Optimizer::preferDelayNeutralMoves()
+{
+	std::vector<char> mask = objectiveComputation_.delayNeutralMask();
+	std::vector<int> candidates;
+	for (int i = 0; i < (int)mask.size(); ++i) {
+		if (mask[i]) {
+			candidates.push_back(i);
+		}
+	}
+	if (!candidates.empty()) {
+		moves_.emplace_back(new MoveInsert(candidates));
+		moves_.emplace_back(new MoveSwap(candidates));
+	}
+	return candidates.size();
+}
+
 bool Optimizer::tryMove()
 {
 	std::uniform_int_distribution<size_t> dist(0, moves_.size() - 1);
@@ -85,6 +65,9 @@ void Optimizer::runGreedy()
 	if (hasObjective(ObjectiveType::PairwiseSecurity)) {
 		runGreedyPairwise();
 	}
+	if (hasObjective(ObjectiveType::AnalyticCorruptibility)) {
+		runGreedyAnalyticCorruptibility();
+	}
 	if (hasObjective(ObjectiveType::Corruption)) {
 		runGreedyCorruptibility();
 		runGreedyOutputCorruptibility();
@@ -127,6 +110,18 @@ void Optimizer::runGreedyPairwise()
 	addGreedySolutions(tot);
 }
 
+void Optimizer::runGreedyAnalyticCorruptibility()
+{
+	// With independent nodes, taking them by decreasing observability is optimal for each size
+	const std::vector<double> &obs = objectiveComputation_.analyticObservability();
+	std::vector<int> tot(obs.size());
+	for (int i = 0; i < (int)tot.size(); ++i) {
+		tot[i] = i;
+	}
+	std::stable_sort(tot.begin(), tot.end(), [&](int a, int b) { return obs[a] > obs[b]; });
+	addGreedySolutions(tot);
+}
+
 void Optimizer::addGreedySolutions(const std::vector<int> &order)
 {
 	for (size_t i = 1; i <= order.size(); ++i) {
@@ -196,16 +191,3 @@ void Optimizer::cleanupParetoFront()
 		return a.first < b.first;
 	});
 }
-
-bool paretoDominates(const std::vector<double> &a, const std::vector<double> &b)
-{
-	if (a.size() != b.size()) {
-		return false;
-	}
-	for (size_t i = 0; i < a.size(); ++i) {
-		if (a[i] < b[i]) {
-			return false;
-		}
-	}
-	return true;
-}
\ No newline at end of file
@@ -5,42 +5,12 @@
 #ifndef MOOSIC_OPTIMIZATION_H
 #define MOOSIC_OPTIMIZATION_H
 
+#include "optimization_moves.hpp"
 #include "optimization_objectives.hpp"
 
+#include <memory>
 #include <random>
 
-class OptimizationMove
-{
-      public:
-	virtual std::vector<int> createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen) = 0;
-	virtual ~OptimizationMove() {}
-};
-
-class LocalMove : public OptimizationMove
-{
-      public:
-	std::vector<int> createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen) final override;
-	virtual std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) = 0;
-};
-
-class MoveInsert final : public LocalMove
-{
-      public:
-	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
-};
-
-class MoveDelete final : public LocalMove
-{
-      public:
-	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
-};
-
-class MoveSwap final : public LocalMove
-{
-      public:
-	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
-};
-
 class Optimizer
 {
       public:
@@ -80,6 +50,13 @@ class Optimizer
 	 */
 	int nbNodes() const { return objectiveComputation_.nbNodes(); }
 
+	/**
+	 * @brief Add moves that only insert locking on nodes that do not increase the delay on their own
+	 *
+	 * @return Number of such nodes
+	 */
+	int preferDelayNeutralMoves();
+
 	/**
 	 * @brief Execute a single move
 	 */
@@ -110,6 +87,11 @@ class Optimizer
 	 */
 	void runGreedyPairwise();
 
+	/**
+	 * @brief Add solutions from the analytic corruptibility, by decreasing observability
+	 */
+	void runGreedyAnalyticCorruptibility();
+
 	/**
 	 * @brief Compute the N-dimensional objective value
 	 */
@@ -159,9 +141,4 @@ class Optimizer
 	std::vector<ObjectiveType> objectives_;
 };
 
-/**
- * Returns whether the first vector is better than the second in the Pareto sense (better on every objective, higher is better)
- */
-bool paretoDominates(const std::vector<double> &a, const std::vector<double> &b);
-
 #endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "optimization_moves.hpp"
+
+#include <algorithm>
+
+std::vector<int> LocalMove::createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen)
+{
+	std::uniform_int_distribution<size_t> dist(0, solutionPool.size());
+	size_t ind = dist(rgen);
+	const std::vector<int> sol = ind < solutionPool.size() ? solutionPool[ind] : std::vector<int>();
+	return modifySolution(nbNodes, sol, rgen);
+}
+
+std::vector<int> MoveInsert::modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen)
+{
+	int added;
+	if (candidates_.empty()) {
+		std::uniform_int_distribution<int> dist(0, nbNodes - 1);
+		added = dist(rgen);
+	} else {
+		std::uniform_int_distribution<size_t> dist(0, candidates_.size() - 1);
+		added = candidates_[dist(rgen)];
+	}
+	if (std::find(solution.begin(), solution.end(), added) != solution.end()) {
+		return std::vector<int>();
+	}
+	std::vector<int> ret = solution;
+	ret.push_back(added);
+	return ret;
+}
+
+std::vector<int> MoveDelete::modifySolution(int, const std::vector<int> &solution, std::mt19937 &rgen)
+{
+	if (solution.empty()) {
+		return std::vector<int>();
+	}
+	std::uniform_int_distribution<size_t> dist(0, solution.size() - 1);
+	size_t deleted = dist(rgen);
+	std::vector<int> ret = solution;
+	ret.erase(ret.begin() + deleted);
+	return ret;
+}
+
+std::vector<int> MoveSwap::modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen)
+{
+	auto inserted = insert_.modifySolution(nbNodes, solution, rgen);
+	return MoveDelete().modifySolution(nbNodes, inserted, rgen);
+}
+
+bool paretoDominates(const std::vector<double> &a, const std::vector<double> &b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i] < b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_OPTIMIZATION_MOVES_H
+#define MOOSIC_OPTIMIZATION_MOVES_H
+
+#include <random>
+#include <vector>
+
+class OptimizationMove
+{
+      public:
+	virtual std::vector<int> createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen) = 0;
+	virtual ~OptimizationMove() {}
+};
+
+class LocalMove : public OptimizationMove
+{
+      public:
+	std::vector<int> createSolution(int nbNodes, const std::vector<std::vector<int>> &solutionPool, std::mt19937 &rgen) final override;
+	virtual std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) = 0;
+};
+
+class MoveInsert final : public LocalMove
+{
+      public:
+	MoveInsert() {}
+
+	/**
+	 * @brief Only insert nodes from a list of candidates
+	 */
+	explicit MoveInsert(const std::vector<int> &candidates) : candidates_(candidates) {}
+
+	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
+
+      private:
+	std::vector<int> candidates_;
+};
+
+class MoveDelete final : public LocalMove
+{
+      public:
+	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
+};
+
+class MoveSwap final : public LocalMove
+{
+      public:
+	MoveSwap() {}
+
+	/**
+	 * @brief Only insert nodes from a list of candidates
+	 */
+	explicit MoveSwap(const std::vector<int> &candidates) : insert_(candidates) {}
+
+	std::vector<int> modifySolution(int nbNodes, const std::vector<int> &solution, std::mt19937 &rgen) override;
+
+      private:
+	MoveInsert insert_;
+};
+
+/**
+ * Returns whether the first vector is better than the second in the Pareto sense (better on every objective, higher is better)
+ */
+bool paretoDominates(const std::vector<double> &a, const std::vector<double> &b);
+
+#endif
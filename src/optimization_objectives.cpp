@@ -4,6 +4,8 @@
 
 #include "optimization_objectives.hpp"
 
+#include "analysis_context.hpp"
+
 std::string toString(ObjectiveType obj)
 {
 	switch (obj) {
@@ -27,6 +29,8 @@ std::string toString(ObjectiveType obj)
 		return "OutputCorruptibilityEstimate";
 	case ObjectiveType::TestCorruptibilityEstimate:
 		return "TestCorruptibilityEstimate";
+	case ObjectiveType::AnalyticCorruptibility:
+		return "AnalyticCorruptibility";
 	default:
 		return "UnknownObjectiveType";
 	}
@@ -58,9 +62,9 @@ ObjectiveType estimation(ObjectiveType obj)
 }
 
 OptimizationObjectives::OptimizationObjectives(Module *module, const std::vector<Cell *> &cells, int nbAnalysisVectors, int nbAnalysisKeys)
-    : logicLockingAnalyzer_(module), logicLockingStats_(cells, nbAnalysisKeys), delayAnalyzer_(module, cells)
+    : logicLockingAnalyzer_(AnalysisContext::get_analyzer(module, nbAnalysisVectors)), logicLockingStats_(cells, nbAnalysisKeys),
+      delayAnalyzer_(module, cells)
 {
-	logicLockingAnalyzer_.gen_test_vectors(nbAnalysisVectors, 1);
 	cells_ = cells;
 	baseArea_ = module->cells().size();
 	baseDelay_ = delayAnalyzer_.delay(std::vector<int>());
@@ -94,6 +98,13 @@ void OptimizationObjectives::setupPairwiseSecurityOptimizer()
 	pairwiseSecurityOptimizer_.reset(new PairwiseSecurityOptimizer(logicLockingAnalyzer_.analyze_pairwise_security(cells_)));
 }
 
+void OptimizationObjectives::setupAnalyticObservability()
+{
+	if (!analyticObservability_.empty() || cells_.empty())
+		return;
+	analyticObservability_ = logicLockingAnalyzer_.compute_cop_observability(cells_);
+}
+
 double OptimizationObjectives::objectiveValue(const Solution &sol, ObjectiveType obj)
 {
 	switch (obj) {
@@ -117,6 +128,8 @@ double OptimizationObjectives::objectiveValue(const Solution &sol, ObjectiveType
 		return corruptibility(sol);
 	case ObjectiveType::Corruption:
 		return corruption(sol);
+	case ObjectiveType::AnalyticCorruptibility:
+		return analyticCorruptibility(sol);
 	default:
 		assert(false);
 		return 0.0;
@@ -125,7 +138,13 @@ double OptimizationObjectives::objectiveValue(const Solution &sol, ObjectiveType
 
 double OptimizationObjectives::area(const Solution &sol) { return 100.0 * sol.size() / std::max(baseArea_, 1); }
 
-double OptimizationObjectives::delay(const Solution &sol) { return 100.0 * (delayAnalyzer_.delay(sol) - baseDelay_) / std::max(baseDelay_, 1); }
+double OptimizationObjectives::delay(const Solution &sol) { return 100.0 * (delayAnalyzer_.incrementalDelay(sol) - baseDelay_) / std::max(baseDelay_, 1); }
+
+std::vector<char> OptimizationObjectives::delayNeutralMask()
+{
+	delayAnalyzer_.incrementalDelay(Solution());
+	return delayAnalyzer_.delayNeutralMask();
+}
 
 double OptimizationObjectives::pairwiseSecurity(const Solution &sol)
 {
@@ -175,3 +194,13 @@ double OptimizationObjectives::corruptibilityEstimate(const Solution &sol)
 	setupCorruptibilityOptimizer();
 	return 100.0 * corruptibilityOptimizer_->corruptibility(sol);
 }
+
+double OptimizationObjectives::analyticCorruptibility(const Solution &sol)
+{
+	setupAnalyticObservability();
+	double notCorrupted = 1.0;
+	for (int c : sol) {
+		notCorrupted *= 1.0 - analyticObservability_[c];
+	}
+	return 100.0 * (1.0 - notCorrupted);
+}
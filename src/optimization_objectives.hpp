@@ -31,7 +31,8 @@ enum class ObjectiveType {
 	TestCorruptibility,
 	CorruptibilityEstimate,
 	OutputCorruptibilityEstimate,
-	TestCorruptibilityEstimate
+	TestCorruptibilityEstimate,
+	AnalyticCorruptibility
 };
 
 /**
@@ -92,6 +93,11 @@ class OptimizationObjectives
 	 */
 	double delay(const Solution &);
 
+	/**
+	 * @brief Return for each node whether locking it alone leaves the delay unchanged
+	 */
+	std::vector<char> delayNeutralMask();
+
 	/**
 	 * @brief Return the output corruptibility objective (0% to 100%, higher is better)
 	 */
@@ -133,6 +139,22 @@ class OptimizationObjectives
 	 */
 	double corruptibilityEstimate(const Solution &);
 
+	/**
+	 * @brief Return an analytic estimation of the test corruptibility objective (0% to 100%, higher is better)
+	 *
+	 * This is computed without simulation from the COP observability of each node, assuming they are independent.
+	 */
+	double analyticCorruptibility(const Solution &);
+
+	/**
+	 * @brief Return the COP observability of each node, used for the analytic corruptibility
+	 */
+	const std::vector<double> &analyticObservability()
+	{
+		setupAnalyticObservability();
+		return analyticObservability_;
+	}
+
 	/**
 	 * @brief Return the pairwise security metrics (in bits, higher is better)
 	 */
@@ -168,6 +190,8 @@ class OptimizationObjectives
 	void setupTestCorruptibilityOptimizer();
 	/// @brief Setup the member on demand
 	void setupPairwiseSecurityOptimizer();
+	/// @brief Setup the member on demand
+	void setupAnalyticObservability();
 
       private:
 	std::vector<Cell *> cells_;
@@ -180,6 +204,7 @@ class OptimizationObjectives
 	std::unique_ptr<OutputCorruptionOptimizer> outputCorruptibilityOptimizer_;
 	std::unique_ptr<OutputCorruptionOptimizer> testCorruptibilityOptimizer_;
 	std::unique_ptr<PairwiseSecurityOptimizer> pairwiseSecurityOptimizer_;
+	std::vector<double> analyticObservability_;
 };
 
 #endif
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <bitset>
 #include <cassert>
+#include <map>
 #include <stdexcept>
 
 OutputCorruptionOptimizer::OutputCorruptionOptimizer(const std::vector<CorruptionData> &data) : outputCorruption_(data)
@@ -100,9 +101,27 @@ std::vector<int> OutputCorruptionOptimizer::getUniqueNodes(const std::vector<int
 }
 
 OutputCorruptionOptimizer::Solution OutputCorruptionOptimizer::solveGreedy(int maxNumber, const Solution &preLocked) const
+{
+	return solveGreedyConstrained(maxNumber, [](int) { return true; }, preLocked);
+}
+
+OutputCorruptionOptimizer::Solution OutputCorruptionOptimizer::solveGreedyConstrained(int maxNumber, const std::function<bool(int)> &accept,
+										      const Solution &preLocked) const
 {
 	check(preLocked);
 	std::vector<int> remaining = getUniqueNodes(preLocked);
+	// Nodes with the same corruption as each unique node, tried in order if the constraint rejects it
+	std::vector<std::vector<int>> duplicates(nbNodes());
+	std::map<CorruptionData, int> representative;
+	for (int k : remaining) {
+		representative.emplace(outputCorruption_[k], k);
+	}
+	for (int i = 0; i < nbNodes(); ++i) {
+		auto it = representative.find(outputCorruption_[i]);
+		if (it != representative.end() && it->second != i) {
+			duplicates[it->second].push_back(i);
+		}
+	}
 	std::vector<int> sol = preLocked;
 	CorruptionData corr(nbData());
 
@@ -116,7 +135,7 @@ OutputCorruptionOptimizer::Solution OutputCorruptionOptimizer::solveGreedy(int m
 	}
 	std::sort(remainingGains.rbegin(), remainingGains.rend());
 
-	for (int i = preLocked.size(); i < std::min(nbNodes(), maxNumber); ++i) {
+	while ((int)sol.size() < std::min(nbNodes(), maxNumber)) {
 		if (remainingGains.empty())
 			break;
 		// Compute the coverage added by each remaining gate
@@ -152,13 +171,21 @@ OutputCorruptionOptimizer::Solution OutputCorruptionOptimizer::solveGreedy(int m
 		}
 		assert(found);
 
-		// Pick the best gate and remove it
-		sol.push_back(bestK);
+		// Pick the best gate or one of its duplicates if allowed, and remove them
 		remainingGains.erase(remainingGains.begin() + toRemove);
+		const std::vector<int> &group = duplicates[bestK];
+		bool accepted = accept(bestK);
+		for (std::size_t j = 0; !accepted && j < group.size(); ++j) {
+			bestK = group[j];
+			accepted = accept(bestK);
+		}
+		if (accepted) {
+			sol.push_back(bestK);
 
-		// Update the corruption
-		for (size_t i = 0; i < corr.size(); ++i) {
-			corr[i] |= outputCorruption_[bestK][i];
+			// Update the corruption
+			for (size_t i = 0; i < corr.size(); ++i) {
+				corr[i] |= outputCorruption_[bestK][i];
+			}
 		}
 
 		// Update the sorting
@@ -6,6 +6,7 @@
 #define MOOSIC_OUTPUT_CORRUPTION_OPTIMIZER_H
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 
 class OutputCorruptionOptimizer
@@ -63,6 +64,16 @@ class OutputCorruptionOptimizer
 	 */
 	Solution solveGreedy(int maxNumber, const Solution &preLocked = std::vector<int>()) const;
 
+	/**
+	 * @brief Maximize output corruption by picking one best gate to lock at a time, subject to a constraint
+	 *
+	 * @param accept Called on the best remaining gate before locking it; if it returns false, it is called on the gates
+	 * with the same corruption in turn, and the gates rejected are discarded.
+	 * The constraint must be monotonic: a gate rejected once is never considered again.
+	 */
+	Solution solveGreedyConstrained(int maxNumber, const std::function<bool(int)> &accept,
+					const Solution &preLocked = std::vector<int>()) const;
+
 	/**
 	 * @brief Check datastructure consistency
 	 */
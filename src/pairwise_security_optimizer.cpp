@@ -3,6 +3,7 @@
  */
 
 #include "pairwise_security_optimizer.hpp"
+#include "phase_trace.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -14,12 +15,16 @@
 PairwiseSecurityOptimizer::PairwiseSecurityOptimizer(const std::vector<std::vector<int>> &pairwiseInterference)
     : pairwiseInterference_(pairwiseInterference)
 {
+	TraceScope trace("clique_enumeration");
 	sortNeighbours();
 	removeSelfLoops();
 	removeDirectedEdges();
 	removeExclusiveEquivalentNodes();
 	cliques_ = listMaximalCliques();
 	check();
+	trace.addCounter("nodes", nbNodes());
+	trace.addCounter("edges", nbEdges());
+	trace.addCounter("cliques", cliques_.size());
 }
 
 void PairwiseSecurityOptimizer::sortNeighbours()
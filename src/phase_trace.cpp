@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "phase_trace.hpp"
+
+#ifdef MOOSIC_YOSYS_PLUGIN
+#include "kernel/yosys.h"
+#else
+#include <iostream>
+#endif
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+
+std::atomic<bool> PhaseTrace::enabled_(false);
+
+namespace
+{
+struct TraceEvent {
+	std::string name;
+	std::int64_t start;
+	std::int64_t duration;
+	int thread;
+	std::vector<std::pair<std::string, long long>> counters;
+};
+
+/// Maximum number of events kept in memory; later events are counted but not recorded
+constexpr std::size_t maxTraceEvents = 1 << 20;
+
+std::mutex traceMutex;
+std::vector<TraceEvent> traceEvents;
+std::size_t nbDroppedEvents = 0;
+std::string traceFile;
+std::atomic<int> nextThreadId(0);
+
+const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+int threadId()
+{
+	thread_local int id = nextThreadId++;
+	return id;
+}
+
+void traceWarning(const std::string &msg)
+{
+#ifdef MOOSIC_YOSYS_PLUGIN
+	Yosys::log_warning("%s\n", msg.c_str());
+#else
+	std::cerr << "Warning: " << msg << std::endl;
+#endif
+}
+
+void writeEscaped(std::ostream &f, const std::string &s)
+{
+	f << '"';
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			f << '\\';
+		}
+		f << c;
+	}
+	f << '"';
+}
+} // namespace
+
+std::int64_t PhaseTrace::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+void PhaseTrace::start(const std::string &filename)
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	if (filename != traceFile) {
+		traceEvents.clear();
+		nbDroppedEvents = 0;
+		traceFile = filename;
+	}
+	enabled_ = true;
+}
+
+void PhaseTrace::stop()
+{
+	std::lock_guard<std::mutex> lock(traceMutex);
+	enabled_ = false;
+	std::ofstream f(traceFile);
+	if (!f) {
+		traceWarning("Could not open trace file " + traceFile + " for writing.");
+		return;
+	}
+	if (nbDroppedEvents > 0) {
+		traceWarning("The trace is limited to " + std::to_string(maxTraceEvents) + " phases: " + std::to_string(nbDroppedEvents) +
+			     " phases were not recorded.");
+	}
+	f << "{\"traceEvents\": [\n";
+	for (std::size_t i = 0; i < traceEvents.size(); ++i) {
+		const TraceEvent &e = traceEvents[i];
+		f << "{\"name\": ";
+		writeEscaped(f, e.name);
+		f << ", \"cat\": \"moosic\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << e.thread << ", \"ts\": " << e.start
+		  << ", \"dur\": " << e.duration << ", \"args\": {";
+		for (std::size_t j = 0; j < e.counters.size(); ++j) {
+			if (j > 0) {
+				f << ", ";
+			}
+			writeEscaped(f, e.counters[j].first);
+			f << ": " << e.counters[j].second;
+		}
+		f << "}}" << (i + 1 < traceEvents.size() ? "," : "") << "\n";
+	}
+	f << "], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": " << nbDroppedEvents << "}}\n";
+}
+
+void PhaseTrace::record(const char *name, std::int64_t start, std::int64_t duration, const std::vector<std::pair<const char *, long long>> &counters)
+{
+	TraceEvent e;
+	e.name = name;
+	e.start = start;
+	e.duration = duration;
+	e.thread = threadId();
+	for (const auto &c : counters) {
+		e.counters.emplace_back(c.first, c.second);
+	}
+	std::lock_guard<std::mutex> lock(traceMutex);
+	if (traceEvents.size() >= maxTraceEvents) {
+		++nbDroppedEvents;
+		return;
+	}
+	traceEvents.push_back(std::move(e));
+}
+
+TraceSession::TraceSession(const char *command, const std::string &filename) : owner_(false)
+{
+	if (PhaseTrace::enabled()) {
+		return;
+	}
+	std::string file = filename;
+	if (file.empty()) {
+		const char *env = std::getenv(PhaseTrace::envVariable);
+		if (env != nullptr) {
+			file = env;
+		}
+	}
+	if (file.empty()) {
+		return;
+	}
+	owner_ = true;
+	PhaseTrace::start(file);
+	scope_.reset(new TraceScope(command));
+}
+
+TraceSession::~TraceSession()
+{
+	if (owner_) {
+		scope_.reset();
+		PhaseTrace::stop();
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_PHASE_TRACE_H
+#define MOOSIC_PHASE_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Process-wide recording of the phases of the analyses, written in Chrome trace-event format
+ *
+ * The trace can be opened in chrome://tracing or Perfetto. Recording is disabled by default and
+ * costs a single atomic load per phase in that case.
+ */
+class PhaseTrace
+{
+      public:
+	/**
+	 * @brief Environment variable giving the trace file, when not specified on the command line
+	 */
+	static constexpr const char *envVariable = "MOOSIC_TRACE";
+
+	/**
+	 * @brief Return whether phases are being recorded
+	 */
+	static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Start recording to this file; events already recorded are kept if the file is the same
+	 */
+	static void start(const std::string &filename);
+
+	/**
+	 * @brief Stop recording and write all recorded events to the file
+	 *
+	 * At most 2^20 phases are kept in memory; a warning reports the number of phases dropped beyond that.
+	 */
+	static void stop();
+
+	/**
+	 * @brief Record a completed phase (times in microseconds since the start of the process)
+	 */
+	static void record(const char *name, std::int64_t start, std::int64_t duration, const std::vector<std::pair<const char *, long long>> &counters);
+
+	/**
+	 * @brief Current time in microseconds
+	 */
+	static std::int64_t now();
+
+      private:
+	static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief Scoped timer for a phase, recorded in the trace when it goes out of scope
+ */
+class TraceScope
+{
+      public:
+	explicit TraceScope(const char *name) : name_(name), active_(PhaseTrace::enabled())
+	{
+		if (active_) {
+			start_ = PhaseTrace::now();
+		}
+	}
+
+	TraceScope(const TraceScope &) = delete;
+	TraceScope &operator=(const TraceScope &) = delete;
+
+	/**
+	 * @brief Attach a counter (number of nodes, signals, ...) to the phase
+	 */
+	void addCounter(const char *name, long long value)
+	{
+		if (active_) {
+			counters_.emplace_back(name, value);
+		}
+	}
+
+	~TraceScope()
+	{
+		if (active_) {
+			PhaseTrace::record(name_, start_, PhaseTrace::now() - start_, counters_);
+		}
+	}
+
+      private:
+	const char *name_;
+	bool active_;
+	std::int64_t start_ = 0;
+	std::vector<std::pair<const char *, long long>> counters_;
+};
+
+/**
+ * @brief Enable tracing for the duration of a command, to the given file or the one given by the environment
+ *
+ * Nested sessions have no effect; the trace is written when the outermost session ends.
+ * With the environment variable, consecutive commands accumulate their phases in the same file.
+ */
+class TraceSession
+{
+      public:
+	explicit TraceSession(const char *command, const std::string &filename = std::string());
+	TraceSession(const TraceSession &) = delete;
+	TraceSession &operator=(const TraceSession &) = delete;
+	~TraceSession();
+
+      private:
+	bool owner_;
+	std::unique_ptr<TraceScope> scope_;
+};
+
+#endif
@@ -1,12 +1,17 @@
 
+#include "analysis_context.hpp"
 #include "command_utils.hpp"
+#include "corruption_analysis.hpp"
 #include "delay_analyzer.hpp"
 #include "logic_locking_analyzer.hpp"
 #include "logic_locking_statistics.hpp"
+#include "phase_trace.hpp"
+#include "signal_probability.hpp"
 
 #include "kernel/rtlil.h"
 #include "kernel/yosys.h"
 
+#include <bitset>
 #include <random>
 
 USING_YOSYS_NAMESPACE
@@ -73,8 +78,7 @@ void report_security(LogicLockingAnalyzer &pw, LogicLockingKeyStatistics &runner
  */
 void report_security(RTLIL::Module *module, const std::vector<Cell *> &cells, int nb_analysis_vectors, int nb_analysis_keys)
 {
-	LogicLockingAnalyzer pw(module);
-	pw.gen_test_vectors(nb_analysis_vectors / 64, 1);
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(module, nb_analysis_vectors / 64);
 
 	LogicLockingKeyStatistics runner(cells, nb_analysis_keys);
 	report_security(pw, runner);
@@ -93,8 +97,7 @@ void report_security(RTLIL::Module *module, const std::string &port_name, std::v
 	}
 	key.resize(sigs.size(), false);
 
-	LogicLockingAnalyzer pw(module);
-	pw.gen_test_vectors(nb_analysis_vectors / 64, 1);
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(module, nb_analysis_vectors / 64);
 
 	// Set the test vectors for the port to the key value
 	pw.set_input_values(sigs, key);
@@ -105,8 +108,196 @@ void report_security(RTLIL::Module *module, const std::string &port_name, std::v
 	report_security(pw, runner);
 }
 
+void report_signal_skew(RTLIL::Module *module, const std::string &port_name, std::uint64_t nb_patterns, int nb_threads, int nb_reported)
+{
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(module);
+	std::vector<Lit> key_lits;
+	Wire *w = module->wire(Yosys::RTLIL::escape_id(port_name));
+	if (w == nullptr) {
+		log_warning("Port %s not found in module; the distance to the key will not be reported.\n", port_name.c_str());
+	} else {
+		for (SigBit b : SigSpec(w)) {
+			key_lits.push_back(pw.get_aig_literal(b));
+		}
+	}
+
+	std::vector<Cell *> cells = pw.get_lockable_cells();
+	std::vector<SigBit> signals = pw.get_lockable_signals();
+	std::vector<Lit> lits;
+	for (SigBit s : signals) {
+		lits.push_back(pw.get_aig_literal(s));
+	}
+
+	SignalProbabilityAnalyzer skew(pw.aig(), key_lits);
+	skew.run(nb_patterns, nb_threads);
+	std::vector<int> order = skew.rank(lits);
+
+	int nb_key_dependent = 0;
+	int nb_skewed = 0;
+	for (Lit l : lits) {
+		if (skew.keyDistance(l) >= 0) {
+			++nb_key_dependent;
+			if (skew.skew(l) == 0.5) {
+				++nb_skewed;
+			}
+		}
+	}
+	log("Signal probability computed on %lu random patterns for %d gates, %d depending on the key.\n", (unsigned long)skew.nbPatterns(),
+	    GetSize(lits), nb_key_dependent);
+	log("%d key-dependent gates never changed value; they are candidates for removal attacks.\n", nb_skewed);
+	log("\n");
+	log("%10s %10s %10s   %s\n", "Prob.", "Skew", "Key dist.", "Cell");
+	for (int i = 0; i < std::min(nb_reported, GetSize(order)); ++i) {
+		Lit l = lits[order[i]];
+		int dist = skew.keyDistance(l);
+		log("%10.6f %10.6f %10s   %s\n", skew.probability(l), skew.skew(l), dist >= 0 ? std::to_string(dist).c_str() : "-",
+		    log_id(cells[order[i]]->name));
+	}
+}
+
+void report_simulation_profile(RTLIL::Module *module, int nb_analysis_vectors, int nb_reported)
+{
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(module);
+	std::vector<Cell *> cells = pw.get_lockable_cells();
+	std::vector<Lit> lits;
+	for (SigBit s : pw.get_lockable_signals()) {
+		lits.push_back(pw.get_aig_literal(s));
+	}
+	const MiniAIG &aig = pw.aig();
+	int nb_vectors = std::max(1, nb_analysis_vectors / 64);
+	std::vector<ToggleProfile> profile = profileIncrementalSimulation(aig, generateTestVectors(aig.nbInputs(), nb_vectors, 1), lits);
+	if (profile.empty()) {
+		log("No lockable signal to profile.\n");
+		return;
+	}
+
+	std::vector<int> cone_sizes;
+	long long total_masked = 0;
+	IncrementalSimStats total;
+	for (const ToggleProfile &p : profile) {
+		cone_sizes.push_back(p.coneSize);
+		total_masked += p.nbMasked;
+		total.nbToggles += p.stats.nbToggles;
+		total.nbEvaluated += p.stats.nbEvaluated;
+		total.nbChanged += p.stats.nbChanged;
+		total.nbHeapOps += p.stats.nbHeapOps;
+		total.bytesTouched += p.stats.bytesTouched;
+	}
+	std::sort(cone_sizes.begin(), cone_sizes.end());
+	double avg_cone = 0.0;
+	for (int c : cone_sizes) {
+		avg_cone += c;
+	}
+	avg_cone /= GetSize(cone_sizes);
+	double masked = (double)total_masked / ((double)GetSize(profile) * nb_vectors);
+
+	log("Incremental simulation profile of %d signals on %d test vectors (64 patterns each), with %d Aig nodes.\n", GetSize(profile),
+	    nb_vectors, aig.nbNodes());
+	log("Fanout cone size: average %.1f, median %d, 90th percentile %d, max %d.\n", avg_cone, cone_sizes[GetSize(cone_sizes) / 2],
+	    cone_sizes[GetSize(cone_sizes) * 9 / 10], cone_sizes.back());
+	log("%.1f%% of the simulations did not change any output.\n", 100.0 * masked);
+	log("\n");
+	log("%12s %10s\n", "Cone size", "Signals");
+	for (long long bound = 1, i = 0; i < GetSize(cone_sizes); bound *= 4) {
+		int count = 0;
+		while (i < GetSize(cone_sizes) && cone_sizes[i] <= bound) {
+			++count;
+			++i;
+		}
+		log("%12s %10d\n", ("<= " + std::to_string(bound)).c_str(), count);
+	}
+	log("\n");
+
+	if (SimContext::hasSimStats) {
+		double nb_sims = std::max<double>(1.0, total.nbToggles);
+		double evaluated = total.nbEvaluated / nb_sims;
+		log("Per simulation: %.1f nodes evaluated (%.1f%% of the fanout cone), %.1f changed, %.1f queue operations, %.0f bytes touched.\n",
+		    evaluated, 100.0 * evaluated / std::max(1.0, avg_cone), total.nbChanged / nb_sims, total.nbHeapOps / nb_sims,
+		    total.bytesTouched / nb_sims);
+		if (evaluated > 0.5 * aig.nbNodes()) {
+			log("Toggles reach most of the Aig: a full bit-parallel simulation would be cheaper than incremental simulation.\n");
+		} else if (masked > 0.5) {
+			log("Most simulations do not reach an output: pruning the fanout cones would avoid useless work.\n");
+		} else {
+			log("The work is spread over useful propagations: more threads would help the most.\n");
+		}
+	} else {
+		log("Simulation counters are not compiled in; build with ENABLE_SIM_STATS=1 for the number of nodes evaluated.\n");
+	}
+	log("\n");
+
+	// Hot spots, by simulation work if available or by cone size
+	std::vector<int> order(GetSize(profile));
+	for (int i = 0; i < GetSize(order); ++i) {
+		order[i] = i;
+	}
+	auto cost = [&](int i) { return SimContext::hasSimStats ? (double)profile[i].stats.nbEvaluated / nb_vectors : (double)profile[i].coneSize; };
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return cost(a) > cost(b); });
+	log("%12s %10s %10s   %s\n", "Cost", "Cone size", "Masked", "Cell");
+	for (int i = 0; i < std::min(nb_reported, GetSize(order)); ++i) {
+		const ToggleProfile &p = profile[order[i]];
+		log("%12.1f %10d %9.1f%%   %s\n", cost(order[i]), p.coneSize, 100.0 * p.nbMasked / nb_vectors, log_id(cells[order[i]]->name));
+	}
+}
+
+void report_screening(RTLIL::Module *module, int nb_patterns, int nb_reported)
+{
+	LogicLockingAnalyzer pw = AnalysisContext::get_analyzer(module);
+	std::vector<Cell *> cells = pw.get_lockable_cells();
+	std::vector<Lit> lits;
+	for (SigBit s : pw.get_lockable_signals()) {
+		lits.push_back(pw.get_aig_literal(s));
+	}
+	const MiniAIG &aig = pw.aig();
+	int nb_vectors = (nb_patterns + 63) / 64;
+	auto corruption = computeOutputCorruptionLaneSliced(aig, generateTestVectors(aig.nbInputs(), nb_vectors, 1), lits, nb_patterns);
+	if (corruption.empty()) {
+		log("No lockable signal to screen.\n");
+		return;
+	}
+
+	// Number of patterns with a corrupted output, and of corrupted output bits, for each signal
+	std::vector<int> nb_corrupted_patterns(GetSize(corruption));
+	std::vector<long long> nb_corrupted_bits(GetSize(corruption));
+	int nb_unobservable = 0;
+	for (int i = 0; i < GetSize(corruption); ++i) {
+		std::vector<std::uint64_t> any(nb_vectors, 0);
+		for (const auto &o : corruption[i]) {
+			for (int w = 0; w < nb_vectors; ++w) {
+				any[w] |= o[w];
+				nb_corrupted_bits[i] += std::bitset<64>(o[w]).count();
+			}
+		}
+		for (int w = 0; w < nb_vectors; ++w) {
+			nb_corrupted_patterns[i] += std::bitset<64>(any[w]).count();
+		}
+		if (nb_corrupted_patterns[i] == 0) {
+			++nb_unobservable;
+		}
+	}
+
+	log("Screening of %d signals on %d patterns, with 64 signals per simulation (%d simulations of %d Aig nodes).\n",
+	    GetSize(corruption), nb_patterns, nb_patterns * ((GetSize(corruption) + 63) / 64 + 1), aig.nbNodes());
+	log("%d signals do not corrupt any output on these patterns, and are unlikely to be useful for locking.\n", nb_unobservable);
+	log("\n");
+
+	std::vector<int> order(GetSize(corruption));
+	for (int i = 0; i < GetSize(order); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return nb_corrupted_bits[a] > nb_corrupted_bits[b]; });
+	log("%12s %12s   %s\n", "Patterns", "Outputs", "Cell");
+	for (int i = 0; i < std::min(nb_reported, GetSize(order)); ++i) {
+		int c = order[i];
+		log("%11.1f%% %11.1f%%   %s\n", 100.0 * nb_corrupted_patterns[c] / nb_patterns,
+		    100.0 * nb_corrupted_bits[c] / ((double)nb_patterns * std::max(1, aig.nbOutputs())), log_id(cells[c]->name));
+	}
+}
+
 void report_locking(Yosys::RTLIL::Module *mod, const std::vector<Yosys::RTLIL::Cell *> &cells, int nb_analysis_keys, int nb_analysis_vectors)
 {
+	TraceScope trace("report_locking");
+	trace.addCounter("locked", cells.size());
 	report_area(mod, cells);
 	report_timing(mod, cells);
 	report_security(mod, cells, nb_analysis_vectors, nb_analysis_keys);
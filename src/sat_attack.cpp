@@ -4,15 +4,29 @@
 
 #include "sat_attack.hpp"
 
+#include "analysis_cache.hpp"
+#include "analysis_context.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 USING_YOSYS_NAMESPACE
 
 SatAttack::SatAttack(RTLIL::Module *mod, const std::string &portName, const std::vector<bool> &expectedKey)
-    : mod_(mod), keyPortName_(portName), expectedKey_(expectedKey), keyFound_(false), analyzer_(mod)
+    : mod_(mod), keyPortName_(portName), expectedKey_(expectedKey), keyFound_(false), analyzer_(AnalysisContext::get_analyzer(mod))
 {
+	// No signal is toggled during the attack: all redundant nodes can be removed before encoding
+	analyzer_.sweep_aig(false);
+	sim_.reset(new SimContext(analyzer_.aig()));
 	nbOutputs_ = analyzer_.nb_outputs();
 	nbKeyBits_ = getKeyPort()->width;
 	nbInputs_ = analyzer_.nb_inputs() - nbKeyBits_;
 	timeLimit_ = std::numeric_limits<double>::infinity();
+	checkpointInterval_ = 0.0;
+	nbQueries_ = 0;
+	totalSolveTime_ = 0.0;
 
 	// Size sanity checks
 	if (GetSize(expectedKey_) < nbKeyBits_) {
@@ -24,6 +38,181 @@ SatAttack::SatAttack(RTLIL::Module *mod, const std::string &portName, const std:
 
 	// Truncate the key to the useful bits
 	expectedKey_.resize(nbKeyBits_, false);
+
+	// Locate the key bits among the AIG inputs
+	RTLIL::Wire *keyPort = getKeyPort();
+	for (SigBit v : analyzer_.get_comb_inputs()) {
+		aigKeyIndex_.push_back(v.wire == keyPort ? v.offset : -1);
+	}
+	removeRestriction();
+}
+
+void SatAttack::removeRestriction()
+{
+	activeKeyBits_.clear();
+	for (int i = 0; i < nbKeyBits(); ++i) {
+		activeKeyBits_.push_back(i);
+	}
+	activeOutputs_.clear();
+	for (int i = 0; i < nbOutputs(); ++i) {
+		activeOutputs_.push_back(i);
+	}
+	activeVars_.assign(aig().nbInputs() + aig().nbNodes() + 1, true);
+}
+
+namespace
+{
+int findRepresentative(std::vector<int> &parent, int i)
+{
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+/**
+ * @brief Mark the AIG variables in the transitive fanin of the given outputs
+ */
+std::vector<char> computeFaninCone(const MiniAIG &aig, const std::vector<int> &outputs)
+{
+	std::vector<char> inCone(aig.nbInputs() + aig.nbNodes() + 1, false);
+	for (int o : outputs) {
+		inCone[aig.output(o).variable()] = true;
+	}
+	for (int i = aig.nbNodes() - 1; i >= 0; --i) {
+		if (inCone[i + aig.nbInputs() + 1]) {
+			inCone[aig.nodeA(i).variable()] = true;
+			inCone[aig.nodeB(i).variable()] = true;
+		}
+	}
+	return inCone;
+}
+} // namespace
+
+std::vector<std::vector<int>> SatAttack::computeKeyGroups() const
+{
+	// Only nodes that reach an output can merge two key bits
+	std::vector<int> allOutputs;
+	for (int i = 0; i < nbOutputs(); ++i) {
+		allOutputs.push_back(i);
+	}
+	std::vector<char> inCone = computeFaninCone(aig(), allOutputs);
+
+	// Propagate a representative key bit through the AIG, merging the key bits that meet at a node
+	std::vector<int> parent(nbKeyBits());
+	for (int i = 0; i < nbKeyBits(); ++i) {
+		parent[i] = i;
+	}
+	std::vector<int> rep(aig().nbInputs() + aig().nbNodes() + 1, -1);
+	for (int i = 0; i < aig().nbInputs(); ++i) {
+		rep[i + 1] = aigKeyIndex_[i];
+	}
+	for (int i = 0; i < aig().nbNodes(); ++i) {
+		int v = i + aig().nbInputs() + 1;
+		if (!inCone[v]) {
+			continue;
+		}
+		int ra = rep[aig().nodeA(i).variable()];
+		int rb = rep[aig().nodeB(i).variable()];
+		if (ra >= 0 && rb >= 0) {
+			ra = findRepresentative(parent, ra);
+			rb = findRepresentative(parent, rb);
+			parent[rb] = ra;
+		}
+		rep[v] = ra >= 0 ? ra : rb;
+	}
+
+	// Gather the groups, ordered by their smallest key bit
+	std::vector<int> groupIndex(nbKeyBits(), -1);
+	std::vector<std::vector<int>> groups;
+	for (int i = 0; i < nbKeyBits(); ++i) {
+		int r = findRepresentative(parent, i);
+		if (groupIndex[r] < 0) {
+			groupIndex[r] = groups.size();
+			groups.emplace_back();
+		}
+		groups[groupIndex[r]].push_back(i);
+	}
+	return groups;
+}
+
+void SatAttack::restrictToKeyGroup(const std::vector<int> &keyBits)
+{
+	activeKeyBits_ = keyBits;
+	std::vector<char> isActiveKey(nbKeyBits(), false);
+	for (int k : keyBits) {
+		assert(k >= 0 && k < nbKeyBits());
+		isActiveKey[k] = true;
+	}
+
+	// Find which variables depend structurally on the active key bits
+	std::vector<char> dependsOnKey(aig().nbInputs() + aig().nbNodes() + 1, false);
+	for (int i = 0; i < aig().nbInputs(); ++i) {
+		int k = aigKeyIndex_[i];
+		dependsOnKey[i + 1] = k >= 0 && isActiveKey[k];
+	}
+	for (int i = 0; i < aig().nbNodes(); ++i) {
+		dependsOnKey[i + aig().nbInputs() + 1] = dependsOnKey[aig().nodeA(i).variable()] || dependsOnKey[aig().nodeB(i).variable()];
+	}
+	activeOutputs_.clear();
+	for (int i = 0; i < nbOutputs(); ++i) {
+		if (dependsOnKey[aig().output(i).variable()]) {
+			activeOutputs_.push_back(i);
+		}
+	}
+	activeVars_ = computeFaninCone(aig(), activeOutputs_);
+}
+
+void SatAttack::runDecomposed(double errorThreshold, int nbInitialVectors, int nbDIQueries, int nbRandomVectors, int settleThreshold)
+{
+	std::vector<std::vector<int>> groups = computeKeyGroups();
+	int largestGroup = 0;
+	for (const auto &group : groups) {
+		largestGroup = std::max(largestGroup, GetSize(group));
+	}
+	log("Decomposed the %d key bits into %d independent groups; the largest has %d key bits\n", nbKeyBits(), GetSize(groups), largestGroup);
+
+	auto decompositionStart = std::chrono::steady_clock::now();
+	double totalTimeLimit = timeLimit_;
+	std::vector<bool> combinedKey(nbKeyBits(), false);
+	for (int g = 0; g < GetSize(groups); ++g) {
+		const std::vector<int> &group = groups[g];
+		restrictToKeyGroup(group);
+		if (activeOutputs_.empty()) {
+			log("Key group %d/%d with %d key bits does not affect any output: its value is irrelevant\n", g + 1, GetSize(groups),
+			    GetSize(group));
+			continue;
+		}
+		log("Attacking key group %d/%d with %d key bits and %d outputs\n", g + 1, GetSize(groups), GetSize(group), nbActiveOutputs());
+		// The groups are attacked one after the other and share the time limit
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - decompositionStart;
+		timeLimit_ = std::max(totalTimeLimit - elapsed.count(), 0.0);
+		if (timeLimit_ <= 0.0) {
+			timeLimit_ = totalTimeLimit;
+			removeRestriction();
+			stopOnTimeLimit("Time limit reached.\n");
+		}
+		if (errorThreshold <= 0.0) {
+			runSat(nbInitialVectors);
+		} else {
+			runAppSat(errorThreshold, nbInitialVectors, nbDIQueries, nbRandomVectors, settleThreshold);
+		}
+		if (!keyFound_) {
+			log("No key found for key group %d/%d\n", g + 1, GetSize(groups));
+			timeLimit_ = totalTimeLimit;
+			removeRestriction();
+			return;
+		}
+		for (int k : group) {
+			combinedKey[k] = bestKey_[k];
+		}
+	}
+	timeLimit_ = totalTimeLimit;
+	removeRestriction();
+	bestKey_ = combinedKey;
+	keyFound_ = true;
+	log("Combined the keys of %d groups: %s\n", GetSize(groups), create_hex_string(bestKey_).c_str());
 }
 
 std::vector<bool> SatAttack::genInputVector()
@@ -53,7 +242,7 @@ double SatAttack::elapsedTime() const
 
 void SatAttack::runSat(int nbInitialVectors)
 {
-	log("Starting Sat attack with %d inputs, %d outputs and %d key bits\n", nbInputs(), nbOutputs(), nbKeyBits());
+	log("Starting Sat attack with %d inputs, %d outputs and %d key bits\n", nbInputs(), nbActiveOutputs(), nbActiveKeyBits());
 	if (!runPrologue(nbInitialVectors)) {
 		return;
 	}
@@ -69,22 +258,23 @@ void SatAttack::runSat(int nbInitialVectors)
 			break;
 		}
 		if (elapsedTime() > timeLimit_) {
-			log_cmd_error("Time limit reached.\n");
+			stopOnTimeLimit("Time limit reached.\n");
 		}
 		++i;
 		log("\tFound a differenciating input with key %s.\n", create_hex_string(candidateKey).c_str());
 		addTestVector(candidateInputs);
 		found = findNewValidKey(bestKey_);
 		if (elapsedTime() > timeLimit_) {
-			log_cmd_error("Time limit reached.\n");
-			break;
+			stopOnTimeLimit("Time limit reached.\n");
 		}
 		if (!found) {
 			bestKey_.clear();
 			log("No valid key found with the new test vector.\n");
 			break;
 		}
+		checkpoint();
 	}
+	logSolverSummary();
 	if (keyFound_) {
 		if (!keyPassesTests(bestKey_)) {
 			log_error("Found key does not pass the test vectors.\n");
@@ -96,7 +286,7 @@ void SatAttack::runSat(int nbInitialVectors)
 
 void SatAttack::runAppSat(double errorThreshold, int nbInitialVectors, int nbDIQueries, int nbRandomVectors, int settleThreshold)
 {
-	log("Starting approximate Sat attack with %d inputs, %d outputs and %d key bits\n", nbInputs(), nbOutputs(), nbKeyBits());
+	log("Starting approximate Sat attack with %d inputs, %d outputs and %d key bits\n", nbInputs(), nbActiveOutputs(), nbActiveKeyBits());
 	if (!runPrologue(nbInitialVectors)) {
 		return;
 	}
@@ -122,12 +312,12 @@ void SatAttack::runAppSat(double errorThreshold, int nbInitialVectors, int nbDIQ
 			continue;
 		}
 		if (elapsedTime() > timeLimit_) {
-			log_cmd_error("Time limit reached.\n");
-			break;
+			stopOnTimeLimit("Time limit reached.\n");
 		}
 
 		// Measure the error on random vectors, and at most double the number of constraints
 		double epsilon = measureErrorAndConstrain(nbRandomVectors, nbTestVectors());
+		checkpoint();
 		if (epsilon < errorThreshold) {
 			++settleCount;
 			// Wait settleCount times until we consider the key good enough
@@ -141,6 +331,7 @@ void SatAttack::runAppSat(double errorThreshold, int nbInitialVectors, int nbDIQ
 			settleCount = 0;
 		}
 	}
+	logSolverSummary();
 }
 
 double SatAttack::measureErrorAndConstrain(int nbRandomVectors, int maxConstraints)
@@ -162,24 +353,43 @@ double SatAttack::measureErrorAndConstrain(int nbRandomVectors, int maxConstrain
 	}
 	double epsilon = nbRandomVectors <= 0 ? 0.0 : (double)nbErrors / nbRandomVectors;
 	log("\tMeasured error %.3f%% error: %d out of %d test vectors.\n", 100.0 * epsilon, nbErrors, nbRandomVectors);
+	if (telemetry_.is_open()) {
+		telemetry_ << "{\"query\":\"measure_error\",\"time\":" << elapsedTime() << ",\"test_vectors\":" << nbTestVectors()
+			   << ",\"error\":" << epsilon << ",\"errors\":" << nbErrors << ",\"random_vectors\":" << nbRandomVectors << "}\n";
+	}
 	return epsilon;
 }
 
 bool SatAttack::runPrologue(int nbInitialVectors)
 {
 	startTime_ = std::chrono::steady_clock::now();
-	// Generate initial test vectors
+	lastCheckpoint_ = startTime_;
+	nbQueries_ = 0;
+	totalSolveTime_ = 0.0;
+	keyFound_ = false;
+	bestKey_.clear();
 	testInputs_.clear();
 	testOutputs_.clear();
-	for (int i = 0; i < nbInitialVectors; i++) {
-		genTestVector();
+	if (!resumeFile_.empty()) {
+		// Restart from the test vectors of a previous run
+		loadCheckpoint(resumeFile_);
+		log("Resumed from checkpoint %s with %d test vectors\n", resumeFile_.c_str(), nbTestVectors());
+		nbInitialVectors = nbTestVectors();
+	} else {
+		// Generate initial test vectors
+		for (int i = 0; i < nbInitialVectors; i++) {
+			genTestVector();
+		}
 	}
 	// Check the expected key
 	if (!keyPassesTests(expectedKey_)) {
 		log_error("The expected locking key does not pass the random test vectors: there must be a bug.\n");
 	}
 
-	keyFound_ = false;
+	if (!bestKey_.empty() && keyPassesTests(bestKey_)) {
+		log("Restored candidate key for the %d test vectors: %s\n", nbTestVectors(), create_hex_string(bestKey_).c_str());
+		return true;
+	}
 	bestKey_.clear();
 	bool found = findNewValidKey(bestKey_);
 	if (!found) {
@@ -190,6 +400,229 @@ bool SatAttack::runPrologue(int nbInitialVectors)
 	return true;
 }
 
+void SatAttack::setTelemetryFile(const std::string &f)
+{
+	telemetry_.close();
+	if (f.empty()) {
+		return;
+	}
+	telemetry_.open(f);
+	if (!telemetry_) {
+		log_cmd_error("Could not open telemetry file %s\n", f.c_str());
+	}
+}
+
+void SatAttack::recordQuery(const char *query, const ezMiniSAT &sat, std::chrono::steady_clock::time_point solveStart, bool success)
+{
+	std::chrono::duration<double> solveTime = std::chrono::steady_clock::now() - solveStart;
+	++nbQueries_;
+	totalSolveTime_ += solveTime.count();
+	if (!telemetry_.is_open()) {
+		return;
+	}
+	telemetry_ << "{\"query\":\"" << query << "\",\"index\":" << nbQueries_ << ",\"time\":" << elapsedTime()
+		   << ",\"solve_time\":" << solveTime.count() << ",\"sat\":" << (success ? "true" : "false")
+		   << ",\"timeout\":" << (sat.solverTimoutStatus ? "true" : "false") << ",\"variables\":" << sat.numCnfVariables()
+		   << ",\"clauses\":" << sat.numCnfClauses() << ",\"test_vectors\":" << nbTestVectors() << ",\"key_bits\":" << nbActiveKeyBits()
+		   << ",\"outputs\":" << nbActiveOutputs() << "}\n";
+	telemetry_.flush();
+}
+
+void SatAttack::logSolverSummary() const
+{
+	log("Sat attack used %d solver queries and %d test vectors; %.2fs spent in the solver out of %.2fs\n", nbQueries_, nbTestVectors(),
+	    totalSolveTime_, elapsedTime());
+}
+
+void SatAttack::checkpoint()
+{
+	if (checkpointFile_.empty()) {
+		return;
+	}
+	std::chrono::duration<double> sinceLast = std::chrono::steady_clock::now() - lastCheckpoint_;
+	if (sinceLast.count() < checkpointInterval_) {
+		return;
+	}
+	saveCheckpoint(checkpointFile_);
+	lastCheckpoint_ = std::chrono::steady_clock::now();
+}
+
+void SatAttack::stopOnTimeLimit(const char *msg)
+{
+	logSolverSummary();
+	if (!checkpointFile_.empty()) {
+		saveCheckpoint(checkpointFile_);
+		log("Saved checkpoint with %d test vectors to %s\n", nbTestVectors(), checkpointFile_.c_str());
+	}
+	log_cmd_error("%s", msg);
+}
+
+namespace
+{
+const char checkpointMagic[8] = {'M', 'O', 'O', 'S', 'I', 'C', 'C', 'K'};
+const std::uint32_t checkpointVersion = 2;
+
+void writeU32(std::ostream &f, std::uint32_t v)
+{
+	unsigned char buf[4] = {(unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24)};
+	f.write((const char *)buf, 4);
+}
+
+std::uint32_t readU32(std::istream &f)
+{
+	unsigned char buf[4] = {0, 0, 0, 0};
+	f.read((char *)buf, 4);
+	return (std::uint32_t)buf[0] | ((std::uint32_t)buf[1] << 8) | ((std::uint32_t)buf[2] << 16) | ((std::uint32_t)buf[3] << 24);
+}
+
+void writeU64(std::ostream &f, std::uint64_t v)
+{
+	writeU32(f, (std::uint32_t)v);
+	writeU32(f, (std::uint32_t)(v >> 32));
+}
+
+std::uint64_t readU64(std::istream &f)
+{
+	std::uint64_t low = readU32(f);
+	std::uint64_t high = readU32(f);
+	return low | (high << 32);
+}
+
+/**
+ * @brief Number of bytes left to read in a file
+ */
+std::uint64_t remainingBytes(std::istream &f, std::uint64_t fileSize)
+{
+	std::streamoff pos = f.tellg();
+	return pos < 0 || (std::uint64_t)pos > fileSize ? 0 : fileSize - pos;
+}
+
+/**
+ * @brief Write a boolean vector of known size, packed 8 bits per byte
+ */
+void writeBits(std::ostream &f, const std::vector<bool> &v)
+{
+	std::vector<char> buf((v.size() + 7) / 8, 0);
+	for (size_t i = 0; i < v.size(); ++i) {
+		if (v[i]) {
+			buf[i / 8] |= (char)(1 << (i % 8));
+		}
+	}
+	f.write(buf.data(), buf.size());
+}
+
+std::vector<bool> readBits(std::istream &f, int size)
+{
+	std::vector<char> buf((size + 7) / 8, 0);
+	f.read(buf.data(), buf.size());
+	std::vector<bool> v(size);
+	for (int i = 0; i < size; ++i) {
+		v[i] = (buf[i / 8] >> (i % 8)) & 1;
+	}
+	return v;
+}
+} // namespace
+
+std::uint64_t SatAttack::fingerprint() const
+{
+	// The oracle is the design with the expected key: both must match to reuse the test vectors
+	std::uint64_t h = AnalysisCache::canonical_hash(mod_);
+	for (bool b : expectedKey_) {
+		h = (h ^ (b ? 1 : 0)) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+void SatAttack::saveCheckpoint(const std::string &f) const
+{
+	// Write to a temporary file first, so that an interrupted run never leaves a truncated checkpoint
+	std::string tmpFile = f + ".tmp";
+	std::ofstream s(tmpFile, std::ios::binary);
+	if (!s) {
+		log_cmd_error("Could not open checkpoint file %s\n", tmpFile.c_str());
+	}
+	s.write(checkpointMagic, sizeof(checkpointMagic));
+	writeU32(s, checkpointVersion);
+	writeU64(s, fingerprint());
+	writeU32(s, nbInputs());
+	writeU32(s, nbActiveOutputs());
+	writeU32(s, nbKeyBits());
+	writeU32(s, nbTestVectors());
+	for (int i = 0; i < nbTestVectors(); ++i) {
+		writeBits(s, testInputs_[i]);
+		writeBits(s, testOutputs_[i]);
+	}
+	writeU32(s, bestKey_.size());
+	writeBits(s, bestKey_);
+	std::stringstream rngState;
+	rngState << rgen_;
+	std::string rng = rngState.str();
+	writeU32(s, rng.size());
+	s.write(rng.data(), rng.size());
+	s.close();
+	if (!s || std::rename(tmpFile.c_str(), f.c_str()) != 0) {
+		log_cmd_error("Could not write checkpoint file %s\n", f.c_str());
+	}
+}
+
+void SatAttack::loadCheckpoint(const std::string &f)
+{
+	std::ifstream s(f, std::ios::binary | std::ios::ate);
+	if (!s) {
+		log_cmd_error("Could not open checkpoint file %s\n", f.c_str());
+	}
+	std::uint64_t fileSize = s.tellg();
+	s.seekg(0);
+	char magic[sizeof(checkpointMagic)];
+	s.read(magic, sizeof(magic));
+	if (!s || !std::equal(magic, magic + sizeof(magic), checkpointMagic)) {
+		log_cmd_error("File %s is not a Sat attack checkpoint\n", f.c_str());
+	}
+	std::uint32_t version = readU32(s);
+	if (version != checkpointVersion) {
+		log_cmd_error("Checkpoint %s has version %d, expected %d\n", f.c_str(), (int)version, (int)checkpointVersion);
+	}
+	if (readU64(s) != fingerprint()) {
+		log_cmd_error("Checkpoint %s was created for a different design or key\n", f.c_str());
+	}
+	int nbIn = readU32(s);
+	int nbOut = readU32(s);
+	int nbKey = readU32(s);
+	if (nbIn != nbInputs() || nbOut != nbActiveOutputs() || nbKey != nbKeyBits()) {
+		log_cmd_error("Checkpoint %s was created for a design with %d inputs, %d outputs and %d key bits, but this design has %d inputs, "
+			      "%d outputs and %d key bits\n",
+			      f.c_str(), nbIn, nbOut, nbKey, nbInputs(), nbActiveOutputs(), nbKeyBits());
+	}
+	std::uint32_t nbTests = readU32(s);
+	// Each test vector takes at least one byte: a larger count means a corrupted file
+	std::uint64_t testBytes = (nbIn + 7) / 8 + (nbOut + 7) / 8;
+	if (!s || nbTests > remainingBytes(s, fileSize) / std::max<std::uint64_t>(testBytes, 1)) {
+		log_cmd_error("Checkpoint %s is corrupted\n", f.c_str());
+	}
+	testInputs_.clear();
+	testOutputs_.clear();
+	for (std::uint32_t i = 0; i < nbTests; ++i) {
+		testInputs_.push_back(readBits(s, nbIn));
+		testOutputs_.push_back(readBits(s, nbOut));
+	}
+	int keySize = readU32(s);
+	if (keySize != 0 && keySize != nbKeyBits()) {
+		log_cmd_error("Checkpoint %s is corrupted\n", f.c_str());
+	}
+	bestKey_ = readBits(s, keySize);
+	std::uint32_t rngSize = readU32(s);
+	if (!s || rngSize > remainingBytes(s, fileSize)) {
+		log_cmd_error("Checkpoint %s is truncated\n", f.c_str());
+	}
+	std::string rng(rngSize, ' ');
+	s.read(&rng[0], rng.size());
+	if (!s) {
+		log_cmd_error("Checkpoint %s is truncated\n", f.c_str());
+	}
+	std::stringstream rngState(rng);
+	rngState >> rgen_;
+}
+
 void SatAttack::runBruteForce()
 {
 	if (nbKeyBits() >= 32) {
@@ -230,10 +663,7 @@ std::vector<int> boolVectorToSat(const std::vector<bool> &v)
 bool SatAttack::findNewValidKey(std::vector<bool> &key)
 {
 	ezMiniSAT sat;
-	std::vector<int> keyLits;
-	for (int i = 0; i < nbKeyBits(); ++i) {
-		keyLits.push_back(sat.literal());
-	}
+	std::vector<int> keyLits = createKeyLits(sat);
 
 	forceKeyCorrect(sat, keyLits);
 
@@ -247,11 +677,13 @@ bool SatAttack::findNewValidKey(std::vector<bool> &key)
 	if (std::isfinite(timeLimit_)) {
 		sat.solverTimeout = (int)std::max(std::ceil(timeLimit_ - elapsedTime()), 0.0);
 	}
+	auto solveStart = std::chrono::steady_clock::now();
 	bool success = sat.solve(keyLits, key, assume);
+	recordQuery("find_key", sat, solveStart, success);
 
 	if (!success) {
 		if (sat.solverTimoutStatus) {
-			log_cmd_error("Time limit reached while solving the model\n");
+			stopOnTimeLimit("Time limit reached while solving the model\n");
 		}
 		key.clear();
 		return false;
@@ -268,10 +700,7 @@ bool SatAttack::findDIFromBestKey(std::vector<bool> &inputs, std::vector<bool> &
 	key.clear();
 
 	ezMiniSAT sat;
-	std::vector<int> keyLits;
-	for (int i = 0; i < nbKeyBits(); ++i) {
-		keyLits.push_back(sat.literal());
-	}
+	std::vector<int> keyLits = createKeyLits(sat);
 	std::vector<int> inputLits;
 	for (int i = 0; i < nbInputs(); ++i) {
 		inputLits.push_back(sat.literal());
@@ -296,11 +725,13 @@ bool SatAttack::findDIFromBestKey(std::vector<bool> &inputs, std::vector<bool> &
 	if (std::isfinite(timeLimit_)) {
 		sat.solverTimeout = (int)std::max(std::ceil(timeLimit_ - elapsedTime()), 0.0);
 	}
+	auto solveStart = std::chrono::steady_clock::now();
 	bool success = sat.solve(query, res, assume);
+	recordQuery("find_di_best_key", sat, solveStart, success);
 
 	if (!success) {
 		if (sat.solverTimoutStatus) {
-			log_cmd_error("Time limit reached while solving the model\n");
+			stopOnTimeLimit("Time limit reached while solving the model\n");
 		}
 		return false;
 	} else {
@@ -318,14 +749,8 @@ bool SatAttack::findDI(std::vector<bool> &inputs, std::vector<bool> &key1, std::
 	key2.clear();
 
 	ezMiniSAT sat;
-	std::vector<int> keyLits1;
-	for (int i = 0; i < nbKeyBits(); ++i) {
-		keyLits1.push_back(sat.literal());
-	}
-	std::vector<int> keyLits2;
-	for (int i = 0; i < nbKeyBits(); ++i) {
-		keyLits2.push_back(sat.literal());
-	}
+	std::vector<int> keyLits1 = createKeyLits(sat);
+	std::vector<int> keyLits2 = createKeyLits(sat);
 	std::vector<int> inputLits;
 	for (int i = 0; i < nbInputs(); ++i) {
 		inputLits.push_back(sat.literal());
@@ -350,11 +775,13 @@ bool SatAttack::findDI(std::vector<bool> &inputs, std::vector<bool> &key1, std::
 	if (std::isfinite(timeLimit_)) {
 		sat.solverTimeout = (int)std::max(std::ceil(timeLimit_ - elapsedTime()), 0.0);
 	}
+	auto solveStart = std::chrono::steady_clock::now();
 	bool success = sat.solve(query, res, assume);
+	recordQuery("find_di", sat, solveStart, success);
 
 	if (!success) {
 		if (sat.solverTimoutStatus) {
-			log_cmd_error("Time limit reached while solving the model\n");
+			stopOnTimeLimit("Time limit reached while solving the model\n");
 		}
 		return false;
 	} else {
@@ -365,6 +792,15 @@ bool SatAttack::findDI(std::vector<bool> &inputs, std::vector<bool> &key1, std::
 	}
 }
 
+std::vector<int> SatAttack::createKeyLits(ezMiniSAT &sat)
+{
+	std::vector<int> keyLits(nbKeyBits(), ezSAT::CONST_FALSE);
+	for (int k : activeKeyBits_) {
+		keyLits[k] = sat.literal();
+	}
+	return keyLits;
+}
+
 std::vector<int> SatAttack::aigToSat(ezMiniSAT &sat, const std::vector<int> &inputLits, const std::vector<int> &keyLits)
 {
 	assert(GetSize(inputLits) == nbInputs());
@@ -373,16 +809,20 @@ std::vector<int> SatAttack::aigToSat(ezMiniSAT &sat, const std::vector<int> &inp
 	std::vector<int> aigLits;
 	aigLits.push_back(ezSAT::CONST_FALSE); // Initial zero literal in the AIG
 	int inputInd = 0;
-	for (SigBit v : analyzer_.get_comb_inputs()) {
-		if (v.wire == getKeyPort()) {
-			aigLits.push_back(keyLits.at(v.offset));
+	for (int k : aigKeyIndex_) {
+		if (k >= 0) {
+			aigLits.push_back(keyLits.at(k));
 		} else {
 			aigLits.push_back(inputLits.at(inputInd++));
 		}
 	}
 
-	// Create the clauses for each Aig gate
+	// Create the clauses for each Aig gate; gates outside of the active outputs' cone are not needed
 	for (int j = 0; j < aig().nbNodes(); ++j) {
+		if (!activeVars_[j + aig().nbInputs() + 1]) {
+			aigLits.push_back(ezSAT::CONST_FALSE);
+			continue;
+		}
 		Lit nA = aig().nodeA(j);
 		Lit nB = aig().nodeB(j);
 		int aLit = nA.polarity() ? sat.NOT(aigLits.at(nA.variable())) : aigLits.at(nA.variable());
@@ -396,7 +836,7 @@ std::vector<int> SatAttack::aigToSat(ezMiniSAT &sat, const std::vector<int> &inp
 std::vector<int> SatAttack::extractOutputs(ezMiniSAT &sat, const std::vector<int> &aigLits)
 {
 	std::vector<int> outputLits;
-	for (int j = 0; j < aig().nbOutputs(); ++j) {
+	for (int j : activeOutputs_) {
 		Lit out = aig().output(j);
 		int outLit = out.polarity() ? sat.NOT(aigLits.at(out.variable())) : aigLits.at(out.variable());
 		outputLits.push_back(outLit);
@@ -422,7 +862,12 @@ void SatAttack::checkSatTranslation(const std::vector<bool> &inputs, const std::
 	std::vector<int> inputLits = boolVectorToSat(inputs);
 	std::vector<int> keyLits = boolVectorToSat(key);
 	std::vector<int> aigLits = aigToSat(sat, inputLits, keyLits);
-	callDesign(inputs, key);
+	std::vector<std::uint64_t> aigInputs;
+	for (bool b : toAigInputs(inputs, key)) {
+		aigInputs.push_back(b ? (std::uint64_t)-1 : (std::uint64_t)0);
+	}
+	SimContext sim(aig());
+	sim.simulate(aigInputs);
 
 	std::vector<bool> res;
 	std::vector<int> assume;
@@ -430,9 +875,9 @@ void SatAttack::checkSatTranslation(const std::vector<bool> &inputs, const std::
 	if (!success) {
 		log_error("Sat translation failed\n");
 	}
-	assert(GetSize(aig().getState()) == GetSize(res));
+	assert(GetSize(sim.getState()) == GetSize(res));
 	std::vector<bool> expected;
-	for (auto s : aig().getState()) {
+	for (auto s : sim.getState()) {
 		expected.push_back(s != 0);
 	}
 	if (expected != res) {
@@ -452,8 +897,15 @@ std::vector<bool> SatAttack::callOracle(const std::vector<bool> &inputs) { retur
 std::vector<bool> SatAttack::callDesign(const std::vector<bool> &inputs, const std::vector<bool> &key)
 {
 	std::vector<bool> aigInputs = toAigInputs(inputs, key);
-	std::vector<bool> outputs = analyzer_.compute_output_value(aigInputs);
-	return outputs;
+	std::vector<bool> outputs = analyzer_.compute_output_value(*sim_, aigInputs);
+	if (GetSize(activeOutputs_) == nbOutputs()) {
+		return outputs;
+	}
+	std::vector<bool> ret;
+	for (int j : activeOutputs_) {
+		ret.push_back(outputs[j]);
+	}
+	return ret;
 }
 
 std::vector<bool> SatAttack::toAigInputs(const std::vector<bool> &inputs, const std::vector<bool> &key)
@@ -462,9 +914,9 @@ std::vector<bool> SatAttack::toAigInputs(const std::vector<bool> &inputs, const
 	assert(GetSize(key) == nbKeyBits());
 	std::vector<bool> aigInputs;
 	int inputInd = 0;
-	for (SigBit v : analyzer_.get_comb_inputs()) {
-		if (v.wire == getKeyPort()) {
-			aigInputs.push_back(key.at(v.offset));
+	for (int k : aigKeyIndex_) {
+		if (k >= 0) {
+			aigInputs.push_back(key.at(k));
 		} else {
 			aigInputs.push_back(inputs.at(inputInd++));
 		}
@@ -12,7 +12,9 @@
 #include "logic_locking_analyzer.hpp"
 
 #include <chrono>
+#include <fstream>
 #include <limits>
+#include <memory>
 #include <random>
 #include <string>
 
@@ -31,6 +33,30 @@ class SatAttack
 	 */
 	void runAppSat(double errorThreshold, int nbInitialVectors, int nbDIQueries, int nbRandomVectors, int settleThreshold);
 
+	/**
+	 * @brief Run the attack independently on each group of key bits with disjoint output cones, then combine the sub-keys
+	 *
+	 * The groups are attacked sequentially, and the time limit applies to the whole decomposed attack.
+	 */
+	void runDecomposed(double errorThreshold, int nbInitialVectors, int nbDIQueries, int nbRandomVectors, int settleThreshold);
+
+	/**
+	 * @brief Partition the key bits into groups that share no output in their fanout cone
+	 */
+	std::vector<std::vector<int>> computeKeyGroups() const;
+
+	/**
+	 * @brief Restrict the attack to a subset of the key bits and to the outputs they influence
+	 *
+	 * The other key bits are fixed to zero: they do not affect the outputs considered.
+	 */
+	void restrictToKeyGroup(const std::vector<int> &keyBits);
+
+	/**
+	 * @brief Consider all key bits and all outputs again
+	 */
+	void removeRestriction();
+
 	/**
 	 * @brief Check things, initialize the test vectors and the best key; return false if no initial key is found
 	 */
@@ -50,6 +76,10 @@ class SatAttack
 	int nbInputs() const { return nbInputs_; }
 	/// @brief Number of module outputs
 	int nbOutputs() const { return nbOutputs_; }
+	/// @brief Number of outputs considered by the attack
+	int nbActiveOutputs() const { return activeOutputs_.size(); }
+	/// @brief Number of key bits considered by the attack
+	int nbActiveKeyBits() const { return activeKeyBits_.size(); }
 	/// @brief Number of key bits
 	int nbKeyBits() const { return nbKeyBits_; }
 	/// @brief Current number of test vectors
@@ -63,6 +93,34 @@ class SatAttack
 	/// @brief Set the file to export cnf to
 	void setCnfFile(const std::string &f) { cnfFile_ = f; }
 
+	/// @brief Set the file to save the attack state to, and the minimum interval between two saves in seconds
+	void setCheckpointFile(const std::string &f, double interval)
+	{
+		checkpointFile_ = f;
+		checkpointInterval_ = interval;
+	}
+
+	/// @brief Set the file to write per-query metrics to, as JSON lines
+	void setTelemetryFile(const std::string &f);
+
+	/// @brief Set the checkpoint file to resume the attack from
+	void setResumeFile(const std::string &f) { resumeFile_ = f; }
+
+	/**
+	 * @brief Save the test vectors, the best key and the random state to a binary file
+	 */
+	void saveCheckpoint(const std::string &f) const;
+
+	/**
+	 * @brief Restore the test vectors, the best key and the random state from a binary file
+	 */
+	void loadCheckpoint(const std::string &f);
+
+	/**
+	 * @brief Fingerprint of the locked module and of the oracle, stored in the checkpoints
+	 */
+	std::uint64_t fingerprint() const;
+
 	bool keyFound() const { return keyFound_; }
 	const std::vector<bool> &bestKey() const { return bestKey_; }
 
@@ -121,6 +179,11 @@ class SatAttack
 	 */
 	std::vector<bool> toAigInputs(const std::vector<bool> &inputs, const std::vector<bool> &key);
 
+	/**
+	 * @brief Create the Sat literals for the key: free for active key bits, zero for the others
+	 */
+	std::vector<int> createKeyLits(ezMiniSAT &sat);
+
 	/**
 	 * @brief Translate the AIG into Sat and return the literals for each Aig node
 	 */
@@ -151,6 +214,26 @@ class SatAttack
 	 */
 	double elapsedTime() const;
 
+	/**
+	 * @brief Record the metrics of a solver query
+	 */
+	void recordQuery(const char *query, const ezMiniSAT &sat, std::chrono::steady_clock::time_point solveStart, bool success);
+
+	/**
+	 * @brief Report the time spent in the solver
+	 */
+	void logSolverSummary() const;
+
+	/**
+	 * @brief Save a checkpoint if enough time elapsed since the previous one
+	 */
+	void checkpoint();
+
+	/**
+	 * @brief Save a checkpoint if requested and stop the attack
+	 */
+	[[noreturn]] void stopOnTimeLimit(const char *msg);
+
       private:
 	/// @brief Locked module
 	Yosys::RTLIL::Module *mod_;
@@ -165,8 +248,15 @@ class SatAttack
 	/// @brief Correct key to unlock the design
 	std::vector<bool> expectedKey_;
 
-	/// @brief Inded of each AIG input in the concatenated input + key vector
-	// std::vector<int> aigIndex
+	/// @brief Key bit corresponding to each AIG input, or -1 for non-key inputs
+	std::vector<int> aigKeyIndex_;
+
+	/// @brief Key bits that the attack is allowed to modify
+	std::vector<int> activeKeyBits_;
+	/// @brief Outputs checked by the attack
+	std::vector<int> activeOutputs_;
+	/// @brief AIG variables in the fanin cone of the active outputs
+	std::vector<char> activeVars_;
 
 	/// Current test inputs
 	std::vector<std::vector<bool>> testInputs_;
@@ -179,6 +269,8 @@ class SatAttack
 
 	/// Reuse the analyzer for simulation, although it's not really logic locking we're analyzing
 	LogicLockingAnalyzer analyzer_;
+	/// Simulation state reused by the oracle queries
+	std::unique_ptr<SimContext> sim_;
 
 	/// Random number generator
 	std::mt19937 rgen_;
@@ -187,6 +279,20 @@ class SatAttack
 	double timeLimit_;
 	/// Cnf file export
 	std::string cnfFile_;
+	/// Checkpoint file export
+	std::string checkpointFile_;
+	/// Minimum time between two checkpoints
+	double checkpointInterval_;
+	/// Checkpoint file to resume from
+	std::string resumeFile_;
+	/// Telemetry export, one JSON object per query
+	std::ofstream telemetry_;
+	/// Number of solver queries
+	int nbQueries_;
+	/// Total time spent in the solver
+	double totalSolveTime_;
+	/// Time of the last checkpoint
+	std::chrono::steady_clock::time_point lastCheckpoint_;
 
 	/// Start time
 	std::chrono::steady_clock::time_point startTime_;
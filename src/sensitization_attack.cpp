@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "sensitization_attack.hpp"
+
+#include "analysis_context.hpp"
+
+#include <random>
+
+USING_YOSYS_NAMESPACE
+
+namespace
+{
+/// Maximum number of candidate patterns kept for each key bit during simulation
+constexpr int maxCandidates = 4;
+} // namespace
+
+SensitizationAttack::SensitizationAttack(RTLIL::Module *mod, const std::string &portName, const std::vector<bool> &expectedKey)
+    : analyzer_(AnalysisContext::get_analyzer(mod)), expectedKey_(expectedKey)
+{
+	// Only the key inputs are toggled: all redundant nodes can be removed
+	analyzer_.sweep_aig(false);
+	sim_.reset(new SimContext(analyzer_.aig()));
+
+	RTLIL::Wire *keyPort = mod->wire(RTLIL::escape_id(portName));
+	if (keyPort == nullptr) {
+		log_cmd_error("Could not find port %s in module %s\n", portName.c_str(), log_id(mod->name));
+	}
+	keyBits_ = SigSpec(keyPort).to_sigbit_vector();
+
+	// Size sanity checks
+	if (GetSize(expectedKey_) < nbKeyBits()) {
+		log_cmd_error("Given key has %d bits, but the module has %d key bits\n", GetSize(expectedKey_), nbKeyBits());
+	}
+	if (GetSize(expectedKey_) >= nbKeyBits() + 4) {
+		log_warning("Given key has %d bits, but the module has only %d key bits\n", GetSize(expectedKey_), nbKeyBits());
+	}
+	expectedKey_.resize(nbKeyBits(), false);
+
+	for (SigBit v : analyzer_.get_comb_inputs()) {
+		inputKeyBit_.push_back(v.wire == keyPort ? v.offset : -1);
+	}
+	recovered_.assign(nbKeyBits(), false);
+	recoveredKey_.assign(nbKeyBits(), false);
+}
+
+void SensitizationAttack::run(int nbTestVectors, int nbMaskingKeys, int nbSatQueries)
+{
+	log("Starting sensitization attack with %d inputs, %d outputs and %d key bits\n", analyzer_.nb_inputs() - nbKeyBits(),
+	    analyzer_.nb_outputs(), nbKeyBits());
+
+	std::vector<std::vector<std::pair<std::vector<bool>, int>>> candidates;
+	runSimulation(nbTestVectors, nbMaskingKeys, candidates);
+
+	int nbBySimulation = 0;
+	int nbBySat = 0;
+	for (int j = 0; j < nbKeyBits(); ++j) {
+		for (const auto &c : candidates[j]) {
+			if (isIsolating(c.first, c.second, j)) {
+				recoveredKey_[j] = readKeyBit(c.first, c.second, j);
+				recovered_[j] = true;
+				++nbBySimulation;
+				break;
+			}
+		}
+		if (recovered_[j]) {
+			continue;
+		}
+		std::vector<std::vector<bool>> blocked;
+		for (int q = 0; q < nbSatQueries; ++q) {
+			std::vector<bool> pattern;
+			if (!findSensitizingPattern(j, blocked, pattern)) {
+				break;
+			}
+			int output = findIsolatedOutput(pattern, j);
+			if (output >= 0) {
+				recoveredKey_[j] = readKeyBit(pattern, output, j);
+				recovered_[j] = true;
+				++nbBySat;
+				break;
+			}
+			blocked.push_back(pattern);
+		}
+	}
+
+	std::string keyStr;
+	for (int j = 0; j < nbKeyBits(); ++j) {
+		keyStr += recovered_[j] ? (recoveredKey_[j] ? '1' : '0') : '?';
+		if (recovered_[j] && recoveredKey_[j] != expectedKey_[j]) {
+			log_error("Key bit %d was recovered with an incorrect value.\n", j);
+		}
+	}
+	log("Recovered %d out of %d key bits: %d by simulation, %d by Sat-guided search.\n", nbBySimulation + nbBySat, nbKeyBits(),
+	    nbBySimulation, nbBySat);
+	log("Recovered key bits (bit 0 first): %s\n", keyStr.c_str());
+}
+
+void SensitizationAttack::runSimulation(int nbTestVectors, int nbMaskingKeys,
+					std::vector<std::vector<std::pair<std::vector<bool>, int>>> &candidates)
+{
+	int nbOutputs = analyzer_.nb_outputs();
+	candidates.assign(nbKeyBits(), std::vector<std::pair<std::vector<bool>, int>>());
+	analyzer_.gen_test_vectors(nbTestVectors, 1);
+	if (nbTestVectors <= 0 || nbMaskingKeys <= 0) {
+		return;
+	}
+
+	// A key bit is isolated on an output if toggling it always changes the output,
+	// and the output xor the key bit does not depend on the other key bits
+	std::vector<std::vector<std::vector<std::uint64_t>>> isolated(
+	  nbKeyBits(), std::vector<std::vector<std::uint64_t>>(nbOutputs, std::vector<std::uint64_t>(nbTestVectors, (std::uint64_t)-1)));
+	std::vector<std::vector<std::vector<std::uint64_t>>> reference(
+	  nbKeyBits(), std::vector<std::vector<std::uint64_t>>(nbOutputs, std::vector<std::uint64_t>(nbTestVectors, 0)));
+	std::mt19937_64 rgen(1);
+	for (int r = 0; r < nbMaskingKeys; ++r) {
+		std::vector<std::vector<std::uint64_t>> keyValues(nbKeyBits());
+		for (int j = 0; j < nbKeyBits(); ++j) {
+			for (int t = 0; t < nbTestVectors; ++t) {
+				keyValues[j].push_back(rgen());
+			}
+			analyzer_.set_input_values(keyBits_[j], keyValues[j]);
+		}
+		auto base = analyzer_.compute_output_value();
+		auto corr = analyzer_.compute_output_corruption_data_per_signal(keyBits_);
+		for (int j = 0; j < nbKeyBits(); ++j) {
+			for (int o = 0; o < nbOutputs; ++o) {
+				for (int t = 0; t < nbTestVectors; ++t) {
+					std::uint64_t normalized = base[o][t] ^ keyValues[j][t];
+					if (r == 0) {
+						reference[j][o][t] = normalized;
+					} else {
+						isolated[j][o][t] &= ~(normalized ^ reference[j][o][t]);
+					}
+					isolated[j][o][t] &= corr[j][o][t];
+				}
+			}
+		}
+	}
+
+	// Keep a few candidate patterns for each key bit, to be proven with the solver
+	for (int j = 0; j < nbKeyBits(); ++j) {
+		for (int t = 0; t < nbTestVectors && GetSize(candidates[j]) < maxCandidates; ++t) {
+			for (int lane = 0; lane < 64 && GetSize(candidates[j]) < maxCandidates; ++lane) {
+				for (int o = 0; o < nbOutputs; ++o) {
+					if ((isolated[j][o][t] >> lane) & 1) {
+						candidates[j].emplace_back(analyzer_.get_test_pattern(t, lane), o);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+std::vector<int> SensitizationAttack::aigToSat(ezMiniSAT &sat, const std::vector<int> &inputLits) const
+{
+	const MiniAIG &aig = analyzer_.aig();
+	std::vector<int> lits;
+	lits.push_back(ezSAT::CONST_FALSE);
+	lits.insert(lits.end(), inputLits.begin(), inputLits.end());
+	auto toSat = [&](Lit l) -> int {
+		int s = lits[l.variable()];
+		return l.polarity() ? sat.NOT(s) : s;
+	};
+	for (int i = 0; i < aig.nbNodes(); ++i) {
+		lits.push_back(sat.AND(toSat(aig.nodeA(i)), toSat(aig.nodeB(i))));
+	}
+	std::vector<int> outputs;
+	for (int o = 0; o < aig.nbOutputs(); ++o) {
+		outputs.push_back(toSat(aig.output(o)));
+	}
+	return outputs;
+}
+
+std::vector<int> SensitizationAttack::createInputLits(ezMiniSAT &sat, const std::vector<bool> &pattern, std::vector<int> &keyLits) const
+{
+	keyLits.assign(nbKeyBits(), ezSAT::CONST_FALSE);
+	std::vector<int> ret;
+	for (int i = 0; i < GetSize(inputKeyBit_); ++i) {
+		int k = inputKeyBit_[i];
+		if (k >= 0) {
+			keyLits[k] = sat.literal();
+			ret.push_back(keyLits[k]);
+		} else {
+			ret.push_back(pattern[i] ? ezSAT::CONST_TRUE : ezSAT::CONST_FALSE);
+		}
+	}
+	return ret;
+}
+
+bool SensitizationAttack::isIsolating(const std::vector<bool> &pattern, int output, int keyBit)
+{
+	ezMiniSAT sat;
+	std::vector<int> keyLits1, keyLits2;
+	std::vector<int> outputs1 = aigToSat(sat, createInputLits(sat, pattern, keyLits1));
+	std::vector<int> outputs2 = aigToSat(sat, createInputLits(sat, pattern, keyLits2));
+	// Under this pattern, the output xor the key bit must be the same constant for any key
+	int value1 = sat.XOR(outputs1[output], keyLits1[keyBit]);
+	int value2 = sat.XOR(outputs2[output], keyLits2[keyBit]);
+	return !sat.solve(sat.XOR(value1, value2));
+}
+
+int SensitizationAttack::findIsolatedOutput(const std::vector<bool> &pattern, int keyBit)
+{
+	// An isolated output must change when the key bit is toggled with the other key bits at zero
+	std::vector<bool> key(nbKeyBits(), false);
+	std::vector<bool> outputs0 = callDesign(pattern, key);
+	key[keyBit] = true;
+	std::vector<bool> outputs1 = callDesign(pattern, key);
+	for (int o = 0; o < GetSize(outputs0); ++o) {
+		if (outputs0[o] != outputs1[o] && isIsolating(pattern, o, keyBit)) {
+			return o;
+		}
+	}
+	return -1;
+}
+
+bool SensitizationAttack::findSensitizingPattern(int keyBit, const std::vector<std::vector<bool>> &blocked, std::vector<bool> &pattern)
+{
+	ezMiniSAT sat;
+	std::vector<int> dataLits;
+	std::vector<int> inputLits1, inputLits2;
+	int toggledKeyLit = 0;
+	for (int i = 0; i < GetSize(inputKeyBit_); ++i) {
+		int k = inputKeyBit_[i];
+		int lit = sat.literal();
+		inputLits1.push_back(lit);
+		if (k < 0) {
+			dataLits.push_back(lit);
+			inputLits2.push_back(lit);
+		} else if (k == keyBit) {
+			toggledKeyLit = lit;
+			inputLits2.push_back(sat.NOT(lit));
+		} else {
+			inputLits2.push_back(lit);
+		}
+	}
+	log_assert(toggledKeyLit != 0);
+
+	// Toggling the key bit must change an output for some value of the other key bits
+	std::vector<int> outputs1 = aigToSat(sat, inputLits1);
+	std::vector<int> outputs2 = aigToSat(sat, inputLits2);
+	sat.assume(sat.vec_ne(outputs1, outputs2));
+
+	// Patterns that were already tried are excluded
+	for (const std::vector<bool> &b : blocked) {
+		std::vector<int> values;
+		for (int i = 0; i < GetSize(inputKeyBit_); ++i) {
+			if (inputKeyBit_[i] < 0) {
+				values.push_back(b[i] ? ezSAT::CONST_TRUE : ezSAT::CONST_FALSE);
+			}
+		}
+		sat.assume(sat.vec_ne(dataLits, values));
+	}
+
+	std::vector<bool> res;
+	std::vector<int> assume;
+	if (!sat.solve(dataLits, res, assume)) {
+		return false;
+	}
+	pattern.assign(GetSize(inputKeyBit_), false);
+	int d = 0;
+	for (int i = 0; i < GetSize(inputKeyBit_); ++i) {
+		if (inputKeyBit_[i] < 0) {
+			pattern[i] = res[d++];
+		}
+	}
+	return true;
+}
+
+bool SensitizationAttack::readKeyBit(const std::vector<bool> &pattern, int output, int keyBit)
+{
+	// The output is the key bit xor a constant: obtain the constant with the key bit at zero
+	std::vector<bool> key(nbKeyBits(), false);
+	bool constant = callDesign(pattern, key)[output];
+	bool expected = callDesign(pattern, expectedKey_)[output];
+	return expected != constant;
+}
+
+std::vector<bool> SensitizationAttack::callDesign(std::vector<bool> pattern, const std::vector<bool> &key)
+{
+	for (int i = 0; i < GetSize(inputKeyBit_); ++i) {
+		if (inputKeyBit_[i] >= 0) {
+			pattern[i] = key[inputKeyBit_[i]];
+		}
+	}
+	return analyzer_.compute_output_value(*sim_, pattern);
+}
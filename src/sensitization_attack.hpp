@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_SENSITIZATION_ATTACK_H
+#define MOOSIC_SENSITIZATION_ATTACK_H
+
+#include "kernel/yosys.h"
+#include "libs/ezsat/ezminisat.h"
+
+#include "logic_locking_analyzer.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Key sensitization attack
+ *
+ * For each key bit, look for an input pattern that propagates the key bit to an output while
+ * all other key bits are masked: the output is then a known function of this key bit only, and its
+ * value is read from the oracle. Candidate patterns are found by bit-parallel simulation on random
+ * patterns and random values of the other key bits, then by Sat queries; each pattern is proven
+ * isolating by the solver before the key bit is read.
+ */
+class SensitizationAttack
+{
+      public:
+	SensitizationAttack(Yosys::RTLIL::Module *mod, const std::string &portName, const std::vector<bool> &expectedKey);
+
+	/**
+	 * @brief Run the attack
+	 *
+	 * @param nbTestVectors Number of random test vectors (64 patterns each) for the simulation phase
+	 * @param nbMaskingKeys Number of random values of the other key bits tried on each pattern
+	 * @param nbSatQueries Maximum number of Sat-guided patterns tried for each key bit not found by simulation
+	 */
+	void run(int nbTestVectors, int nbMaskingKeys, int nbSatQueries);
+
+	/// @brief Number of key bits
+	int nbKeyBits() const { return keyBits_.size(); }
+
+	/// @brief Whether a key bit was recovered
+	bool isRecovered(int keyBit) const { return recovered_[keyBit]; }
+
+	/// @brief Recovered value of a key bit
+	bool recoveredValue(int keyBit) const { return recoveredKey_[keyBit]; }
+
+      private:
+	/**
+	 * @brief Run the simulation phase and return candidate patterns and outputs for each key bit
+	 */
+	void runSimulation(int nbTestVectors, int nbMaskingKeys, std::vector<std::vector<std::pair<std::vector<bool>, int>>> &candidates);
+
+	/**
+	 * @brief Look for a pattern that sensitizes the key bit to an output for some value of the other key bits
+	 */
+	bool findSensitizingPattern(int keyBit, const std::vector<std::vector<bool>> &blocked, std::vector<bool> &pattern);
+
+	/**
+	 * @brief Prove that the output only depends on the key bit under this pattern, whatever the other key bits
+	 */
+	bool isIsolating(const std::vector<bool> &pattern, int output, int keyBit);
+
+	/**
+	 * @brief Find an output to which the key bit is isolated under this pattern, or -1
+	 */
+	int findIsolatedOutput(const std::vector<bool> &pattern, int keyBit);
+
+	/**
+	 * @brief Read the value of a key bit from the oracle using an isolating pattern
+	 */
+	bool readKeyBit(const std::vector<bool> &pattern, int output, int keyBit);
+
+	/**
+	 * @brief Translate the AIG into Sat with the given input literals and return the literals for each output
+	 */
+	std::vector<int> aigToSat(ezMiniSAT &sat, const std::vector<int> &inputLits) const;
+
+	/**
+	 * @brief Create the Sat literals for the Aig inputs: constants from the pattern for the data inputs, free for the key
+	 */
+	std::vector<int> createInputLits(ezMiniSAT &sat, const std::vector<bool> &pattern, std::vector<int> &keyLits) const;
+
+	/**
+	 * @brief Run the design on a pattern with the given key
+	 */
+	std::vector<bool> callDesign(std::vector<bool> pattern, const std::vector<bool> &key);
+
+      private:
+	LogicLockingAnalyzer analyzer_;
+	/// @brief Simulation state reused by the design queries
+	std::unique_ptr<SimContext> sim_;
+
+	/// @brief Key inputs of the design
+	std::vector<SigBit> keyBits_;
+
+	/// @brief Key bit for each Aig input, or -1 for data inputs
+	std::vector<int> inputKeyBit_;
+
+	/// @brief Key used by the oracle
+	std::vector<bool> expectedKey_;
+
+	/// @brief Key bits recovered by the attack
+	std::vector<bool> recovered_;
+
+	/// @brief Values of the recovered key bits
+	std::vector<bool> recoveredKey_;
+};
+
+#endif
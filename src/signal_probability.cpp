@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#include "signal_probability.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+/// Number of 64-bit words simulated together for each variable; the number of patterns is rounded to a multiple of 64 * blockWords
+constexpr int blockWords = 4;
+} // namespace
+
+SignalProbabilityAnalyzer::SignalProbabilityAnalyzer(const MiniAIG &aig, const std::vector<Lit> &keyInputs) : aig_(aig), nbPatterns_(0)
+{
+	int nbVars = aig.nbInputs() + aig.nbNodes() + 1;
+	keyDistance_.assign(nbVars, -1);
+	for (Lit k : keyInputs) {
+		keyDistance_[k.variable()] = 0;
+	}
+	for (int i = 0; i < aig.nbNodes(); ++i) {
+		int v = i + aig.nbInputs() + 1;
+		int da = keyDistance_[aig.nodeA(i).variable()];
+		int db = keyDistance_[aig.nodeB(i).variable()];
+		int d = da < 0 ? db : (db < 0 ? da : std::min(da, db));
+		if (d >= 0) {
+			keyDistance_[v] = d + 1;
+		}
+	}
+	onesCount_.assign(nbVars, 0);
+}
+
+void SignalProbabilityAnalyzer::simulateBlocks(std::uint64_t begin, std::uint64_t end, std::uint64_t seed,
+					       std::vector<std::uint64_t> &counts) const
+{
+	int nbInputs = aig_.nbInputs();
+	int nbVars = nbInputs + aig_.nbNodes() + 1;
+	std::vector<std::uint64_t> state(nbVars * blockWords, 0);
+	for (std::uint64_t block = begin; block < end; ++block) {
+		// Each block has its own generator, so that the patterns do not depend on the partitioning
+		std::mt19937_64 rgen(seed + block * 0x9E3779B97F4A7C15ULL);
+		for (int v = 1; v <= nbInputs; ++v) {
+			for (int w = 0; w < blockWords; ++w) {
+				state[v * blockWords + w] = rgen();
+			}
+		}
+		for (int i = 0; i < aig_.nbNodes(); ++i) {
+			int v = i + nbInputs + 1;
+			Lit a = aig_.nodeA(i);
+			Lit b = aig_.nodeB(i);
+			std::uint64_t invA = a.polarity() ? (std::uint64_t)-1 : 0;
+			std::uint64_t invB = b.polarity() ? (std::uint64_t)-1 : 0;
+			const std::uint64_t *sa = &state[a.variable() * blockWords];
+			const std::uint64_t *sb = &state[b.variable() * blockWords];
+			std::uint64_t *s = &state[v * blockWords];
+			for (int w = 0; w < blockWords; ++w) {
+				s[w] = (sa[w] ^ invA) & (sb[w] ^ invB);
+			}
+		}
+		for (int v = 1; v < nbVars; ++v) {
+			std::uint64_t c = 0;
+			for (int w = 0; w < blockWords; ++w) {
+				c += std::bitset<64>(state[v * blockWords + w]).count();
+			}
+			counts[v] += c;
+		}
+	}
+}
+
+void SignalProbabilityAnalyzer::run(std::uint64_t nbPatterns, int nbThreads, std::uint64_t seed)
+{
+	if (nbPatterns == 0) {
+		throw std::runtime_error("Signal probability requires at least one pattern");
+	}
+	std::uint64_t patternsPerBlock = 64 * blockWords;
+	std::uint64_t nbBlocks = (nbPatterns + patternsPerBlock - 1) / patternsPerBlock;
+	if (nbThreads <= 0) {
+		nbThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	nbThreads = std::max<std::uint64_t>(1, std::min<std::uint64_t>(nbThreads, nbBlocks));
+
+	std::vector<std::vector<std::uint64_t>> counts(nbThreads, std::vector<std::uint64_t>(onesCount_.size(), 0));
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nbThreads; ++t) {
+		std::uint64_t begin = nbBlocks * t / nbThreads;
+		std::uint64_t end = nbBlocks * (t + 1) / nbThreads;
+		threads.emplace_back(&SignalProbabilityAnalyzer::simulateBlocks, this, begin, end, seed, std::ref(counts[t]));
+	}
+	for (std::thread &t : threads) {
+		t.join();
+	}
+
+	onesCount_.assign(onesCount_.size(), 0);
+	for (const std::vector<std::uint64_t> &c : counts) {
+		for (std::size_t v = 0; v < c.size(); ++v) {
+			onesCount_[v] += c[v];
+		}
+	}
+	nbPatterns_ = nbBlocks * patternsPerBlock;
+}
+
+double SignalProbabilityAnalyzer::probability(Lit l) const
+{
+	if (nbPatterns_ == 0) {
+		throw std::runtime_error("Signal probability requested before simulation");
+	}
+	double p = (double)onesCount_[l.variable()] / (double)nbPatterns_;
+	return l.polarity() ? 1.0 - p : p;
+}
+
+double SignalProbabilityAnalyzer::skew(Lit l) const { return std::abs(probability(l) - 0.5); }
+
+std::vector<int> SignalProbabilityAnalyzer::rank(const std::vector<Lit> &lits) const
+{
+	std::vector<int> order;
+	for (int i = 0; i < (int)lits.size(); ++i) {
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int i, int j) {
+		int di = keyDistance(lits[i]);
+		int dj = keyDistance(lits[j]);
+		if ((di < 0) != (dj < 0)) {
+			return dj < 0;
+		}
+		double si = skew(lits[i]);
+		double sj = skew(lits[j]);
+		if (si != sj) {
+			return si > sj;
+		}
+		return di < dj;
+	});
+	return order;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023-2024 Gabriel Gouvine
+ */
+
+#ifndef MOOSIC_SIGNAL_PROBABILITY_H
+#define MOOSIC_SIGNAL_PROBABILITY_H
+
+#include "mini_aig.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Estimate the signal probability of each node of an AIG by random simulation
+ *
+ * Point-function countermeasures (AntiSAT, SarLock, CasLock...) rely on a gate whose output is almost
+ * always the same value. This gate is close to the key inputs, and is the target of removal attacks.
+ * The analysis reports how skewed each node is, and its distance to the key inputs, to find such gates.
+ */
+class SignalProbabilityAnalyzer
+{
+      public:
+	/**
+	 * @brief Initialize with the AIG to analyze and the literals of the key inputs
+	 */
+	SignalProbabilityAnalyzer(const MiniAIG &aig, const std::vector<Lit> &keyInputs);
+
+	/**
+	 * @brief Run the simulation on random patterns
+	 *
+	 * @param nbPatterns Number of random patterns, rounded up to a multiple of 256 (the patterns simulated together)
+	 * @param nbThreads Number of threads used for simulation; 0 to use all available threads
+	 * @param seed Seed for the random patterns; the result does not depend on the number of threads
+	 */
+	void run(std::uint64_t nbPatterns, int nbThreads = 0, std::uint64_t seed = 1);
+
+	/**
+	 * @brief Number of patterns simulated
+	 */
+	std::uint64_t nbPatterns() const { return nbPatterns_; }
+
+	/**
+	 * @brief Probability of a literal being one
+	 */
+	double probability(Lit l) const;
+
+	/**
+	 * @brief Skew of a literal: distance of its probability to 0.5, between 0.0 and 0.5
+	 */
+	double skew(Lit l) const;
+
+	/**
+	 * @brief Number of gates between a literal and the closest key input, or -1 if it does not depend on the key
+	 */
+	int keyDistance(Lit l) const { return keyDistance_[l.variable()]; }
+
+	/**
+	 * @brief Rank literals by decreasing skew, then by increasing distance to the key
+	 *
+	 * Literals that do not depend on the key come last.
+	 */
+	std::vector<int> rank(const std::vector<Lit> &lits) const;
+
+      private:
+	/**
+	 * @brief Simulate a range of blocks and accumulate the number of ones for each variable
+	 */
+	void simulateBlocks(std::uint64_t begin, std::uint64_t end, std::uint64_t seed, std::vector<std::uint64_t> &counts) const;
+
+      private:
+	const MiniAIG &aig_;
+	std::vector<int> keyDistance_;
+	std::vector<std::uint64_t> onesCount_;
+	std::uint64_t nbPatterns_;
+};
+
+#endif
@@ -17,7 +17,7 @@ function run_benchmark() {
 	nb_antisat=$3
 	antisat=$4
 	name=$(basename "${benchmark}" .blif)
-	stdbuf -oL yosys -m moosic -p "read_blif -sop ${benchmark}; flatten; synth; logic_locking -target outputs -nb-antisat ${nb_antisat} -antisat ${antisat} -key ${key}; synth; ll_sat_attack -key ${key} -time-limit ${time_limit} -error-threshold ${error_threshold}" >"sat_attack/${name}_${antisat}_${nb_antisat}_${error_threshold}.log"
+	stdbuf -oL yosys -m moosic -p "read_blif -sop ${benchmark}; flatten; synth; logic_locking -target outputs -nb-antisat ${nb_antisat} -antisat ${antisat} -key ${key}; synth; ll_sat_attack -key ${key} -time-limit ${time_limit} -error-threshold ${error_threshold} -telemetry sat_attack/${name}_${antisat}_${nb_antisat}_${error_threshold}.jsonl" >"sat_attack/${name}_${antisat}_${nb_antisat}_${error_threshold}.log"
 }
 
 i=0
@@ -46,9 +46,19 @@ $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten;
 # Change port name
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -port-name test_port"
 
+# Timing-driven locking with a delay budget
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -target timing -max-delay-increase 5%"
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -target timing -max-delay-increase 1"
+
+# Only lock cells with positive slack
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -delay-neutral"
+
 # Run exploration
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_explore -area -delay -corruptibility -iter-limit 1000 -time-limit 10 -nb-analysis-keys 121 -nb-analysis-vectors 67"
 
+# Favour cells with positive slack during exploration
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_explore -area -delay -corruptibility -iter-limit 1000 -time-limit 10 -prefer-delay-neutral"
+
 # All objectives at once
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_explore -area -delay -corruptibility -test-corruptibility -output-corruptibility -iter-limit 1000 -time-limit 10"
 
@@ -64,12 +74,32 @@ $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten;
 # Analyze locking result
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -port-name test_port -key 777; ll_analyze -port-name test_port -key 777"
 
+# Signal probability skew of a locked design
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -antisat antisat -nb-antisat 10; ll_analyze -skew -nb-skew-patterns 65536 -nb-threads 2"
+
 # Sat attack
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sat_attack -key 555555"
 
 # Approximate Sat attack and its arguments
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sat_attack -key 555555 -nb-initial-vectors 2 -nb-test-vectors 500 -nb-di-queries 1 -error-threshold 1 -settle-threshold 2"
 
+# Sat attack decomposed by key groups
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sat_attack -key 555555 -decompose"
+
+# Sat attack with telemetry
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sat_attack -key 555555 -error-threshold 1 -telemetry sat_attack.jsonl"
+rm -f sat_attack.jsonl
+
+# Sat attack with checkpoint and resume
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sat_attack -key 555555 -checkpoint sat_attack.ckpt -checkpoint-interval 0; ll_sat_attack -key 555555 -resume sat_attack.ckpt"
+rm -f sat_attack.ckpt
+
+# Sensitization attack
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sensitization_attack -key 555555"
+
+# Sensitization attack and its arguments
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -key 555555; ll_sensitization_attack -key 555555 -nb-test-vectors 4 -nb-masking-keys 4 -nb-sat-queries 2"
+
 # Antisat
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -antisat antisat -nb-antisat 10"
 
@@ -84,3 +114,50 @@ $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten;
 
 # Caslock
 $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -antisat caslock -nb-antisat 10"
+
+# Analysis reused across passes on an unchanged module
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_analyze -nb-analysis-vectors 64; ll_analyze -nb-analysis-vectors 64; logic_locking -nb-locked 5%"
+
+# Persistent analysis cache, filled by the first run and reused by the second
+rm -rf test_analysis_cache
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -nb-locked 5% -cache-dir test_analysis_cache -dry-run"
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -nb-locked 5% -cache-dir test_analysis_cache -dry-run"
+rm -rf test_analysis_cache
+
+# Aiger export with the lockable signals
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_write_aiger test_export.aig"
+rm -f test_export.aig
+
+# Synthetic netlist generation, combinational and sequential
+$cmd yosys -m moosic -p "ll_gen -nb-gates 2000 -nb-inputs 64 -nb-outputs 16 -depth 30 -max-fanout 8 -seed 3; logic_locking -nb-locked 5%"
+$cmd yosys -m moosic -p "ll_gen -nb-gates 5000 -nb-flops 100 -reconvergence 0.5 -name seq; logic_locking -nb-locked 5%"
+
+# Phase tracing, with the option and with the environment variable
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -target hybrid -trace test_trace.json"
+MOOSIC_TRACE=test_trace.json $cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_analyze -nb-analysis-vectors 64; logic_locking -nb-locked 5%"
+rm -f test_trace.json
+
+# Incremental simulation profile
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_analyze -profile -nb-analysis-vectors 128 -nb-reported 10"
+
+# Screening of the lockable signals on a few patterns
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_analyze -screen 16 -nb-reported 10"
+
+# Analytic corruptibility estimate
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; logic_locking -target analytic -nb-locked 5%"
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_explore -area -analytic-corruptibility -iter-limit 1000 -time-limit 10"
+
+# Sweeping merges the redundant logic that is not a lockable signal (internal nodes of the two xors)
+sweep_design=$(mktemp --suffix=.v)
+echo "module sweep(input a, input b, output y1, output y2); assign y1 = a ^ b; assign y2 = b ^ a; endmodule" > $sweep_design
+$cmd yosys -m moosic -p "read_verilog $sweep_design; proc; techmap; logger -expect log \"Sweeping removed 2 out of 6 AIG nodes\" 1; ll_analyze -screen 16; logger -check-expected"
+rm -f $sweep_design
+
+# Editing a cell parameter in place invalidates the analysis reused between passes
+param_design=$(mktemp --suffix=.v)
+echo "module param(input a, input b, input c, output y); assign y = (a & b) | c; endmodule" > $param_design
+$cmd yosys -m moosic -p "read_verilog $param_design; proc; logger -expect log \"Reusing the analysis of module\" 1; ll_analyze -screen 16; ll_analyze -screen 16; setparam -set A_SIGNED 1 t:\$and; ll_analyze -screen 16; logger -check-expected"
+rm -f $param_design
+
+# Benchmarks of the delay analysis and of the Sat attack
+$cmd yosys -m moosic -p "read_blif benchmarks/blif/iscas85-c1355.blif; flatten; synth; ll_bench -min-time 0.1 -nb-key-bits 8"